@@ -33,6 +33,7 @@
 
 SN74HC165N::SN74HC165N( void )
 {
+    _delayMicros    = SN74HC165N_DEFAULT_DELAY_US;
     _loadPin        = 100; 
     _clockEnablePin = 100;
     _clockPin       = 100;
@@ -45,6 +46,20 @@ SN74HC165N::SN74HC165N( void )
 //
 //------------------------------------------------------------------------------------------------------------
 SN74HC165N::SN74HC165N( int loadPin_, int clockEnablePin_, int clockPin_, int dataPin_ )
+{
+    _delayMicros = SN74HC165N_DEFAULT_DELAY_US;
+    begin( loadPin_, clockEnablePin_, clockPin_, dataPin_ );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// SN74HC165N::begin
+//
+// Sets up the pins on a global object in place, so setup() doesn't have to build a temporary
+// and copy it over.
+//
+//------------------------------------------------------------------------------------------------------------
+void SN74HC165N::begin( int loadPin_, int clockEnablePin_, int clockPin_, int dataPin_ )
 {
     _loadPin = loadPin_;
     _clockEnablePin = clockEnablePin_;
@@ -85,8 +100,8 @@ void SN74HC165N::load_latch( void )
     digitalWrite(_clockEnablePin, HIGH);
     digitalWrite(_loadPin, LOW);
     
-    // delay 5 usec
-    delayMicroseconds(5);
+    // hold the load pulse, 5 usec until the chain has been calibrated
+    if (_delayMicros > 0) delayMicroseconds(_delayMicros);
     
     digitalWrite(_loadPin, HIGH);
     digitalWrite(_clockEnablePin, LOW);
@@ -116,10 +131,52 @@ void SN74HC165N::shift( )
 {
     digitalWrite(_clockPin, HIGH);
 
-    // delay 5 usec
-    delayMicroseconds(5);
+    // hold the clock pulse, 5 usec until the chain has been calibrated
+    if (_delayMicros > 0) delayMicroseconds(_delayMicros);
     
     digitalWrite(_clockPin, LOW);
 }
 
+//------------------------------------------------------------------------------------------------------------
+// SN74HC165N::readChain
+//
+// Reads the chain as a packed value, used by the self test.  Shifting past the end of the chain
+// reads whatever the first register's serial input is tied to.
+//
+//------------------------------------------------------------------------------------------------------------
+
+uint64_t SN74HC165N::readChain( int bits )
+{
+    uint64_t value = 0;
+    
+    load_latch();
+    
+    for (int b=0; b<bits && b<64; b++) {
+        if (readBit()) value |= (1ULL << b);
+        shift();
+    }
+    
+    return( value );
+}
+
+//------------------------------------------------------------------------------------------------------------
+// SN74HC165N::setPulseDelay
+//
+//------------------------------------------------------------------------------------------------------------
+
+void SN74HC165N::setPulseDelay( int delayMicros_ )
+{
+    _delayMicros = (delayMicros_ > 0) ? delayMicros_ : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------
+// SN74HC165N::pulseDelay
+//
+//------------------------------------------------------------------------------------------------------------
+
+int SN74HC165N::pulseDelay( void ) const
+{
+    return( _delayMicros );
+}
+
 
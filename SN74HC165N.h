@@ -78,6 +78,8 @@
 #define FALSE 0
 #endif
 
+#define SN74HC165N_DEFAULT_DELAY_US 5
+
 
 //------------------------------------------------------------------------------------------------------------
 // class CxTime
@@ -96,6 +98,9 @@ class SN74HC165N
    ~SN74HC165N( void );
 	// destructor
 
+    void begin( int loadPin_, int clockEnablePin_, int clockPin_, int dataPin_ );
+    // assign and initialize the pins on an already constructed object
+
     void load_latch( void );
     // load a new value
     
@@ -105,8 +110,18 @@ class SN74HC165N
     void shift( void );
     // shift the bits
     
+    uint64_t readChain( int bits );
+    // load and shift in up to 64 bits, the first bit read ends up in bit 0
+
+    void setPulseDelay( int delayMicros_ );
+    // how long the load and clock pulses are held, in microseconds
+
+    int pulseDelay( void ) const;
+    // the current pulse delay
+
   private:
 
+    int _delayMicros;
     int _loadPin;
     int _clockEnablePin;
     int _clockPin;
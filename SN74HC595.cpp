@@ -47,6 +47,18 @@ SN74HC595::SN74HC595( void )
 //
 //------------------------------------------------------------------------------------------------------------
 SN74HC595::SN74HC595( int SHCP_, int STCP_, int DS_ )
+{
+    begin( SHCP_, STCP_, DS_ );
+}
+
+//------------------------------------------------------------------------------------------------------------
+// SN74HC595::begin
+//
+// Sets up the pins on a global object in place, so setup() doesn't have to build a temporary
+// and copy it over.
+//
+//------------------------------------------------------------------------------------------------------------
+void SN74HC595::begin( int SHCP_, int STCP_, int DS_ )
 {
     _SHCP = SHCP_;
     _STCP = STCP_;
@@ -86,7 +98,7 @@ void SN74HC595::latch_output( void )
 // SN74HC595::writeBit
 //
 // Shift in a 1 or 0 in the shift register.  This bit will not appear at output of shift registers
-// until latch_output is called.
+// until latch_output is called.  Returns the bit written.
 //
 //------------------------------------------------------------------------------------------------------------
 int SN74HC595::writeBit( int bit )
@@ -100,6 +112,8 @@ int SN74HC595::writeBit( int bit )
     }
     
     digitalWrite( _SHCP, HIGH);
+    
+    return( bit ? HIGH : LOW );
 }
     
 
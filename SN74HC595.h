@@ -80,11 +80,14 @@ class SN74HC595
    ~SN74HC595( void );
 	// destructor
 
+    void begin( int shcp_, int stcp_, int ds_ );
+    // assign and initialize the pins on an already constructed object
+
     void latch_output( void );
     // load a new value
     
     int writeBit( int bit );
-    // read the next bit
+    // shift in the next bit, returns the level written
     
     void shift( void );
     // shift the bits
@@ -52,6 +52,32 @@
 #include "cxstring.h"
 #include "cxslist.h"
 #include "cxzone.h"
+#include "cxtimerwheel.h"
+#include "cxpublisher.h"
+#include "cxloopprofile.h"
+#include "cxheapstats.h"
+#include "cxcheckpoint.h"
+#include "cxeventcodec.h"
+#include "cxsnapshot.h"
+#include "cxperiodic.h"
+#include "cxzonestats.h"
+#include "cxhistory.h"
+#include "cxflapdetector.h"
+#include "cxarming.h"
+#include "cxschedule.h"
+#include "cxzonegroups.h"
+#include "cxzoneindex.h"
+#include "cxtokenizer.h"
+#include "cxconfigblob.h"
+#include "cxledengine.h"
+#include "cxchaintest.h"
+
+// run the cloud connection on its own system thread so loop() (and setup()) never wait on the network.
+// All publishing goes through the CxPublisher thread.
+SYSTEM_THREAD(ENABLED);
+
+// keep the zone checkpoint in backup SRAM across resets
+STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
 
 // a few constants in the system
 #define TOTAL_CHANNELS 48
@@ -72,9 +98,6 @@ int LED_MAPPING [48] = {
     47, 46, 45, 44, 43, 42, 41, 40              
 };
 
-// this array is used to represent the desired state of the LED's
-int zoneLEDBits[ TOTAL_CHANNELS ];
-
 
 //------------------------------------------------------------------------------------------------------------
 // This is the channel definition map. It indicates where the channel is located, what its 
@@ -153,8 +176,7 @@ char *chanDef[ TOTAL_CHANNELS ][ NUM_PROPERTIES ] = {
 //
 //------------------------------------------------------------------------------------------------------------
 
-int blinkState = 0;
-int counter    = 0;
+int counter    = 0;                     // passes through loop() since the last heartbeat
 
 CxString openBracket  = "{";
 CxString closeBracket = "}";
@@ -168,9 +190,247 @@ SN74HC165N zoneInputShiftRegister;
 // interface class to the bank of output shift registers that connect to the zone led's
 SN74HC595  LEDOutputShiftRegister;
 
+// refreshes the LED's from a timer, loop() only tells it which pattern each LED plays.  The longest
+// a refresh has taken and how many frames have really gone out to the chain are kept for the 
+// "ledFrameUs" and "ledShifts" variables
+CxLedEngine ledEngine( &LEDOutputShiftRegister );
+int         ledFrameUs = 0;
+int         ledShifts  = 0;
+
+// self test of the zone input chain, run at startup and by "cmd selftest".  Sets the pulse delay the
+// chain is read with, the result goes out in the restart message
+CxChainTest chainTest;
+
 // the link list that holds all the zone data
 CxSList< CxZone *> zoneList;
 
+// direct index into the zones in channel order so the scan never walks the list
+CxZone *zoneTable[ TOTAL_CHANNELS ];
+
+// packed zone state, bit n is channel n.  Maintained by read_zones() so the relay decision
+// is a single AND instead of another pass over the zones
+uint64_t zoneConfiguredBits = 0;
+uint64_t zoneActivatedBits  = 0;
+
+// time from the start of the chain read until the relay pin has been driven, in microseconds.
+// Exposed as Particle variables so we can see how quickly the legacy panel hears about a zone
+int relayLatencyUs    = 0;
+int relayLatencyMaxUs = 0;
+
+// live state for the cloud to poll.  The loop keeps these current as it goes so reading them never
+// formats anything.  "zones" is "<activated>/<configured>" as fixed width hex, rewritten in place
+// only when a bit changes
+#define LIVE_ZONE_DIGITS 12
+char     liveZonesText[ 2 * LIVE_ZONE_DIGITS + 2 ];
+uint64_t liveActivatedBits  = 0;
+uint64_t liveConfiguredBits = 0;
+int      liveSequence       = 0;        // last sequence number handed out
+int      loopUs             = 0;        // last pass through loop(), without the delay
+int      loopMaxUs          = 0;        // longest pass since the last heartbeat
+
+// queue and thread that do all the Particle.publish work.  If the queue can't be created at startup
+// nothing will ever be sent, so loop() says so with one direct publish as soon as the cloud is up
+CxPublisher publisher;
+int         publisherFailed = FALSE;
+
+#ifdef USE_LOOP_PROFILE
+// per phase timing of loop(), rendered into loopProfileText every PROFILE_RENDER_MS for the
+// loopProfile Particle variable and summarized in the heartbeat
+#define PROFILE_RENDER_MS 10000
+CxLoopProfile loopProfile;
+char loopProfileText[ 600 ];
+char loopProfileScratch[ 600 ];
+CxPeriodic profileRenderSchedule;
+#endif
+
+// zone state, sequence numbers and unconfirmed transitions kept in retained memory for a warm restart
+CxCheckpoint checkpoint;
+
+// prefix of every event key, "<device id>-<sequence>" is unique across devices and restarts
+CxString deviceId;
+int checkpointResent = 0;
+
+#ifdef USE_COMPACT_EVENTS
+// batch of zone transitions waiting to go out as one compact access_changed event
+CxEventCodec  compactBatch;
+unsigned long compactFirstSequence = 0;     // first transition the batch covers
+CxTimerHandle compactFlushTimer = TIMER_HANDLE_NONE;
+int           compactFlushDue   = FALSE;
+#endif
+
+// micros() at the end of each startup stage, reported in the restart message
+#define STARTUP_PINS         0
+#define STARTUP_ZONES        1
+#define STARTUP_RESTORE      2
+#define STARTUP_FIRST_SCAN   3
+#define STARTUP_FIRST_LEDS   4
+#define STARTUP_SELF_TEST    5
+#define STARTUP_CLOUD        6
+#define STARTUP_STAGES       7
+
+const char   *startupStageNames[ STARTUP_STAGES ] = { "pins", "zones", "restore", "first_scan", "first_leds", 
+                                                      "self_test", "cloud" };
+unsigned long startupMicros[ STARTUP_STAGES ];
+int           timeToFirstScanUs = 0;
+int           restartPending    = TRUE;
+
+// timer wheel for zone delays, holdoffs and publish retries, advanced once at the top of each loop
+CxTimerWheel timerWheel;
+
+// per zone open counts and times, one zone at a time is rendered into the "zoneStats" variable by 
+// "cmd stats"
+CxZoneStats zoneStats;
+char        zoneStatsText[ 160 ];
+
+// recent transitions kept on the device, read back into the "history" variable by "cmd history"
+#define HISTORY_QUERY_MAX 30
+CxHistory history;
+char      historyText[ 600 ];
+int       historyTextLength;
+
+// zones toggling too often to be believed, their transitions are held back until they settle
+CxFlapDetector flapDetector;
+
+// motion zones collapse retriggers inside MOTION_HOLDOFF_MS into one event, a running holdoff timer
+// means the zone is still busy.  Zones whose holdoff ran out wait in motionSettledBits for 
+// publish_changes()
+#define MOTION_HOLDOFF_MS 60000
+CxTimerHandle motionHoldoff[ TOTAL_CHANNELS ];
+uint64_t      motionSettledBits = 0;
+
+// how a zone transition is handled, returns TRUE if the transition should be sent
+typedef int (*ZoneTransitionHandler)( int channel, CxZone *zone, unsigned long now, unsigned long nowMillis, int *queued );
+
+// zone state as last sent to the cloud, differs from zoneActivatedBits while a zone is flapping
+uint64_t zoneReportedBits = 0;
+
+// TRUE while publish_changes() is waiting for the cloud to set the clock
+int clockHeld = FALSE;
+
+// zone id to channel for the "cmd" arguments.  Only zones in use are indexed, at load and as the
+// cloud configures them, so the unused channels that all share the id "X" don't resolve to anything
+CxZoneIndex zoneIndex;
+
+// configuration pushed from the cloud and kept in EEPROM, applied over the channel map as a diff.
+// How long the last apply took is kept for the "configUs" variable
+CxConfigBlob zoneConfig;
+uint64_t     defaultConfiguredBits = 0;     // zones ACTIVE in the channel map
+int          configApplyUs         = 0;
+
+// zones grouped by room, compiled at load.  A room is open while any of its zones is open as far as
+// the cloud knows, the open rooms can be read from the "rooms" variable or one at a time through 
+// "cmd room"
+CxZoneGroups zoneGroups;
+char         roomsText[ 256 ];
+char         roomsScratch[ 256 ];
+
+// the "status" variable, rendered by update_status() only when something in it has changed so reading
+// it never costs the device any formatting
+struct StatusKey {
+    uint64_t openBits;
+    uint64_t alarmBits;
+    uint64_t entryBits;
+    uint64_t bypassBits;
+    int      mode;
+};
+
+StatusKey statusKey;
+char      statusText[ 200 ];
+char      statusScratch[ 200 ];
+
+// arming mode, bypass and entry / exit delays decide which open zones open the relay and page as
+// CRITICAL.  With no mode saved the system starts AWAY, which watches every zone like it always did
+CxArming arming;
+uint64_t alarmReportedBits = 0;         // zones the cloud has been sent as CRITICAL and still open
+
+// message types for zone events, checkpointed transitions keep theirs as an index into the names so
+// a resend goes out exactly as the original did
+#define SEVERITY_RECOVERY    0
+#define SEVERITY_WARNING     1
+#define SEVERITY_INFO        2
+#define SEVERITY_CRITICAL    3
+#define SEVERITY_COUNT       4
+
+const char *severityNames[ SEVERITY_COUNT ] = { "RECOVERY", "WARNING", "INFO", "CRITICAL" };
+
+// entry and exit delays in seconds, every other zone is instant
+struct ZoneDelay {
+    const char *id;
+    int         entrySeconds;
+    int         exitSeconds;
+};
+
+#define ZONE_DELAY_COUNT 3
+ZoneDelay zoneDelays[ ZONE_DELAY_COUNT ] = {
+    { "G_O_D",  30, 60 },               // Garage Outside Door
+    { "GE_S_D", 30, 60 },               // Door from Garage
+    { "ME_S_D", 30, 60 }                // Front Door
+};
+
+// weekly bypass schedule, compiled at load into the times the bypassed zones change.  Times are local,
+// set SCHEDULE_TIME_ZONE to the standard (winter) offset from UTC, US daylight saving is applied
+#define SCHEDULE_TIME_ZONE  (-7L * 3600)
+#define SCHEDULE_USE_DST    TRUE
+
+struct ScheduleEntry {
+    const char *id;
+    int         days;                   // SCHEDULE_ day bits
+    int         startMinute;            // minutes after local midnight
+    int         endMinute;              // before startMinute runs past midnight
+};
+
+#define SCHEDULE_ENTRY_COUNT 1
+ScheduleEntry scheduleEntries[ SCHEDULE_ENTRY_COUNT ] = {
+    { "G_O_D", SCHEDULE_WEEKDAYS, 8 * 60, 18 * 60 }     // Garage Outside Door, business hours
+};
+
+CxSchedule bypassSchedule;
+
+// heartbeat schedule on millis(), the interval and jitter can be changed with "cmd heartbeat"
+#define HEARTBEAT_INTERVAL_MS  3600000
+#define HEARTBEAT_JITTER_MS    60000
+CxPeriodic heartbeatSchedule;
+
+
+//------------------------------------------------------------------------------------------------------------
+// format_event_key( unsigned long sequence )
+// 
+// Builds the idempotency key for an event.  Sequence numbers are never reused by a device, even
+// across a cold start, so the receiver can drop any event whose key it has already seen.
+//
+//------------------------------------------------------------------------------------------------------------
+
+CxString format_event_key( unsigned long sequence )
+{
+    char buffer[20];
+    
+    sprintf(buffer, "-%lu", sequence );
+    
+    return( deviceId + buffer );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// format_sequence_json( unsigned long sequence )
+// 
+// The "seq":<n>,"event_key":"<key>" fields shared by the SYSTEM payloads
+//
+//------------------------------------------------------------------------------------------------------------
+
+CxString format_sequence_json( unsigned long sequence )
+{
+    char buffer[20];
+    
+    sprintf(buffer, "%lu", sequence );
+    
+    CxString data;
+    data += quote + "seq" + quote + colon + buffer;
+    data += comma;
+    data += quote + "event_key" + quote + colon + quote + format_event_key( sequence ) + quote;
+    
+    return( data );
+}
+
 
 //------------------------------------------------------------------------------------------------------------
 // format_restart_json( void )
@@ -187,12 +447,20 @@ CxSList< CxZone *> zoneList;
 //    "entity_display_name":"SYSTEM restarted",     <== What you read in the timeline
 //    "state_message":"System has restarted",
 //    "state_start_time":<seconds from epoch>,      <== What time did it happen
-//    "free_memeory":<amount of free memory in photon>
+//    "free_memeory":<amount of free memory in photon>,
+//    "start_type":"WARM",                          <== WARM if zone state came back from retained memory
+//    "restore_us":<time taken to check and restore the checkpoint>,
+//    "resent":<unconfirmed zone transitions queued again from the checkpoint>,
+//    "first_scan_us":<micros from reset until the relay was first driven>,
+//    "startup_us":{"pins":n,"zones":n,"restore":n,"first_scan":n,"first_leds":n,"self_test":n,"cloud":n},
+//    "chain":{"fault":"NONE","scan_delay_us":n,"test_us":n},   <== STUCK or UNSTABLE
+//    "seq":<per device event sequence number>,
+//    "event_key":"<device id>-<seq>"               <== unique per event, for de-duplication
 // }
 //
 //------------------------------------------------------------------------------------------------------------
 
-CxString format_restart_json( void )
+CxString format_restart_json( unsigned long sequence )
 {
     char buffer[100];
     
@@ -203,6 +471,27 @@ CxString format_restart_json( void )
     sprintf(buffer, "%lu", freemem );
     CxString freeMemString = buffer;
 
+    sprintf(buffer, "%lu", checkpoint.restoreMicros() );
+    CxString restoreString = buffer;
+
+    sprintf(buffer, "%d", checkpointResent );
+    CxString resentString = buffer;
+
+    CxString startType = checkpoint.warm() ? "WARM" : "COLD";
+
+    sprintf(buffer, "%d", timeToFirstScanUs );
+    CxString firstScanString = buffer;
+
+    CxString stages = openBracket;
+    for (int stage=0; stage<STARTUP_STAGES; stage++) {
+        sprintf(buffer, "%s\"%s\":%lu", stage ? "," : "", startupStageNames[ stage ], startupMicros[ stage ] );
+        stages += buffer;
+    }
+    stages += closeBracket;
+
+    chainTest.format( buffer, sizeof( buffer ));
+    CxString chainString = buffer;
+
     CxString id       = "SYSTEM_RESTART";
     CxString message  = "SYSTEM restarted";
     CxString severity = "CRITICAL";
@@ -222,6 +511,20 @@ CxString format_restart_json( void )
     data += quote + "state_start_time" + quote + colon + startTimeString.data();
     data += comma;
     data += quote + "free_memory" + quote + colon + freeMemString.data();
+    data += comma;
+    data += quote + "start_type" + quote + colon + quote + startType + quote;
+    data += comma;
+    data += quote + "restore_us" + quote + colon + restoreString.data();
+    data += comma;
+    data += quote + "resent" + quote + colon + resentString.data();
+    data += comma;
+    data += quote + "first_scan_us" + quote + colon + firstScanString.data();
+    data += comma;
+    data += quote + "startup_us" + quote + colon + stages;
+    data += comma;
+    data += quote + "chain" + quote + colon + chainString.data();
+    data += comma;
+    data += format_sequence_json( sequence );
     data += closeBracket;
 
     return( data );
@@ -241,12 +544,25 @@ CxString format_restart_json( void )
 //    "entity_display_name":"System heartbeat",
 //    "state_message":"System has restarted",
 //    "state_start_time":<seconds from epoch>,
-//    "free_memeory":<amount of free memory in photon>
+//    "free_memeory":<amount of free memory in photon>,
+//    "publish_dropped":<events lost because the publish queue was full>,
+//    "interval_ms":<actual time since the last heartbeat>,
+//    "loops":<passes through loop() in that time>,         <== scan rate is loops / interval_ms
+//    "skipped":<heartbeat deadlines missed since reset>,
+//    "loop_us":[[min,avg,max],...],                         <== phase timings since the last heartbeat, in
+//                                                           <== loop,scan,relay,timers,publish,led order
+//    "loop_hist":[<16us,<64us,<256us,<1ms,<4ms,<16ms,<64ms,more],
+//    "zone_stats":[opens,busiest,longest],                  <== opens since reset and the channels with the
+//                                                           <== most opens and the longest single open
+//    "configured":"<hex>",                                   <== zone snapshot, see cxsnapshot.h.  Lets the
+//    "activated":"<hex>",                                    <== receiver notice a lost transition without
+//    "last_seq":<sequence of the last event before this one> <== waiting for the zone to change again
+//    "seq":<n>,"event_key":"<device id>-<seq>"
 // }
 //
 //------------------------------------------------------------------------------------------------------------
 
-CxString format_heartbeat_json( void )
+CxString format_heartbeat_json( unsigned long sequence )
 {
     char buffer[100];
     
@@ -257,6 +573,9 @@ CxString format_heartbeat_json( void )
     sprintf(buffer, "%lu", freemem );
     CxString freeMemString = buffer;
 
+    sprintf(buffer, "%lu", publisher.dropped() );
+    CxString droppedString = buffer;
+
     CxString id       = "SYSTEM_HEARTBEAT";
     CxString message  = "SYSTEM heartbeat";
     CxString severity = "INFO";
@@ -276,6 +595,56 @@ CxString format_heartbeat_json( void )
     data += quote + "state_start_time" + quote + colon + startTimeString.data();
     data += comma;
     data += quote + "free_memory" + quote + colon + freeMemString.data();
+    data += comma;
+    data += quote + "publish_dropped" + quote + colon + droppedString.data();
+
+    sprintf(buffer, "%lu", heartbeatSchedule.lastInterval() );
+    data += comma;
+    data += quote + "interval_ms" + quote + colon + buffer;
+
+    sprintf(buffer, "%d", counter );
+    data += comma;
+    data += quote + "loops" + quote + colon + buffer;
+
+    sprintf(buffer, "%lu", heartbeatSchedule.skipped() );
+    data += comma;
+    data += quote + "skipped" + quote + colon + buffer;
+
+#ifdef USE_LOOP_PROFILE
+    char profileBuffer[200];
+
+    loopProfile.formatSummary( profileBuffer, sizeof( profileBuffer ));
+    data += comma;
+    data += quote + "loop_us" + quote + colon + profileBuffer;
+
+    loopProfile.formatHistogram( PHASE_LOOP, profileBuffer, sizeof( profileBuffer ));
+    data += comma;
+    data += quote + "loop_hist" + quote + colon + profileBuffer;
+#endif
+
+    char statsBuffer[40];
+
+    zoneStats.formatSummary( statsBuffer, sizeof( statsBuffer ));
+    data += comma;
+    data += quote + "zone_stats" + quote + colon + statsBuffer;
+
+#ifdef USE_HEAP_STATS
+    char heapBuffer[160];
+
+    CxHeapStats::format( heapBuffer, sizeof( heapBuffer ));
+    data += comma;
+    data += quote + "heap" + quote + colon + heapBuffer;
+#endif
+
+    char snapshotBuffer[100];
+
+    CxZoneSnapshot snapshot( zoneConfiguredBits, zoneActivatedBits, sequence - 1 );
+    snapshot.format( snapshotBuffer, sizeof( snapshotBuffer ));
+    data += comma;
+    data += snapshotBuffer;
+    data += comma;
+    data += format_sequence_json( sequence );
+
     data += closeBracket;
 
     return( data );
@@ -283,290 +652,1861 @@ CxString format_heartbeat_json( void )
 
 
 //------------------------------------------------------------------------------------------------------------
-// channel_load_list 
+// format_mode_json( unsigned long sequence )
+// 
+// Creates a json blob announcing an arming mode change
 //
-// loads the static config data for the system into a c++ zone array structure
+// EXAMPLE
+// {
+//    "channel_number":"SYSTEM",
+//    "message_type":"INFO",
+//    "entity_id":"SYSTEM_MODE",
+//    "entity_display_name":"SYSTEM mode AWAY",
+//    "state_start_time":<seconds from epoch>,
+//    "mode":"AWAY",                                 <== DISARMED, STAY or AWAY
+//    "bypassed":"<hex>",                            <== bypassed zones, bit n is channel n
+//    "seq":<n>,"event_key":"<device id>-<seq>"
+// }
 //
 //------------------------------------------------------------------------------------------------------------
-    
-void channel_load_list( void )
+
+CxString format_mode_json( unsigned long sequence )
 {
     char buffer[100];
     
-    for (int channel=0; channel<TOTAL_CHANNELS; channel++) {
-        
-        int configured = FALSE;
-        int activated  = FALSE;
-        CxString configuredString = chanDef[channel][5];
-        
-        if (configuredString == "ACTIVE") {
-            configured = TRUE;
-        }
-
-        CxZone *zone = new CxZone(
-            channel+1,              // channel number
-            chanDef[channel][0],    // room name
-            chanDef[channel][1],    // description
-            chanDef[channel][2],    // compass location
-            chanDef[channel][3],    // sensor type
-            chanDef[channel][4],    // unique id
-            LED_MAPPING[ channel ], // where in output shift registers is that led
-            configured,
-            activated );
-            
-        zoneList.append( zone );
+    sprintf(buffer, "%lu", Time.now() );
+    CxString startTimeString = buffer;
+    
+    CxString modeString = CxArming::modeName( arming.mode() );
+    
+    uint64_t bypassed = arming.bypassBits();
+    if (bypassed >> 32) {
+        sprintf(buffer, "%lx%08lx", (unsigned long)(bypassed >> 32), (unsigned long)(bypassed & 0xFFFFFFFF) );
+    } else {
+        sprintf(buffer, "%lx", (unsigned long) bypassed );
     }
+    CxString bypassString = buffer;
+    
+    CxString data;
+    data += openBracket;
+    data += quote + "channel_number" + quote + colon + quote + "SYSTEM" + quote;
+    data += comma;
+    data += quote + "message_type" + quote + colon + quote + "INFO" + quote;
+    data += comma;
+    data += quote + "entity_id" + quote + colon + quote + "SYSTEM_MODE" + quote;
+    data += comma;
+    data += quote + "entity_display_name" + quote + colon + quote + "SYSTEM mode " + modeString + quote;
+    data += comma;
+    data += quote + "state_start_time" + quote + colon + startTimeString.data();
+    data += comma;
+    data += quote + "mode" + quote + colon + quote + modeString + quote;
+    data += comma;
+    data += quote + "bypassed" + quote + colon + quote + bypassString + quote;
+    data += comma;
+    data += format_sequence_json( sequence );
+    data += closeBracket;
+
+    return( data );
 }
 
 
 //------------------------------------------------------------------------------------------------------------
-// setLEDs 
+// format_flapping_json( CxZone *zone, unsigned long eventTime, unsigned long sequence )
+// 
+// Creates the one notice sent when a zone starts flapping.  The zone's transitions are not sent
+// again until it has been quiet for FLAP_QUIET_MS, then its state at that point is sent as a normal
+// zone event.
 //
-// uses that array of int's that represent each zone in the system and shifts a 1 or 0 out to light 
-// or unlight the led that represents the zone.
+// EXAMPLE
+// {
+//    "channel_number":"<zone number>",
+//    "message_type":"WARNING",
+//    "entity_id":"<zone id>",
+//    "entity_display_name":"<zone description> is FLAPPING",
+//    "state_message":"Zone changed 6 times in 60s, events held until quiet for 300s",
+//    "state_start_time":<seconds from epoch>,
+//    "seq":<n>,"event_key":"<device id>-<seq>"
+// }
 //
 //------------------------------------------------------------------------------------------------------------
 
-void setLEDs( void )
+CxString format_flapping_json( CxZone *zone, unsigned long eventTime, unsigned long sequence )
 {
-    for (int c=0; c<TOTAL_CHANNELS; c++) {
-        LEDOutputShiftRegister.writeBit( zoneLEDBits[ c ] );
-    }
+    char buffer[100];
     
-    LEDOutputShiftRegister.latch_output();
-}
-
-
-//------------------------------------------------------------------------------------------------------------
-// setup
-//
-// The Photon runtime executive calls this function once after device reset.  We use it to setup a few of the
-// classes that communicate with the input and output shift registers used to check the channel zones and
-// light the LED's
-//
-//------------------------------------------------------------------------------------------------------------
+    sprintf(buffer, "%lu", eventTime );
+    CxString startTimeString = buffer;
 
-void setup()
-{
-    pinMode(A0, OUTPUT);
-    digitalWrite(A0, HIGH);
+    sprintf(buffer, "%d", zone->zoneNumber() );
+    CxString zoneNumberString = buffer;
     
-    zoneInputShiftRegister = SN74HC165N( 
-        D2,    // Connects to Parallel load pin the 165
-        D1,    // Connects to Clock Enable pin the 165
-        D0,    // Connects to the Q7 pin the 165
-        D3 );  // Connects to the data pin
-        
-        
-    LEDOutputShiftRegister = SN74HC595(
-        D6,    // Connects to SHCP pin
-        D5,    // Connects to STCP pin
-        D4 );  // Connects to DS pin
+    CxString messageString = zone->description();
+    messageString += " is FLAPPING";
     
-    // load the channel map        
-    channel_load_list( );
+    sprintf(buffer, "Zone changed %d times in %ds, events held until quiet for %ds", 
+            FLAP_THRESHOLD, FLAP_WINDOW_MS / 1000, FLAP_QUIET_MS / 1000 );
+    CxString stateString = buffer;
     
-    CxString json = format_restart_json();
-    Particle.publish( "access_changed" , json.data());
+    CxString data;
+    data += openBracket;
+    data += quote + "channel_number" + quote + colon + quote + zoneNumberString + quote;
+    data += comma;
+    data += quote + "message_type" + quote + colon + quote + "WARNING" + quote;
+    data += comma;
+    data += quote + "entity_id" + quote + colon + quote + zone->id() + quote;
+    data += comma;
+    data += quote + "entity_display_name" + quote + colon + quote + messageString + quote;
+    data += comma;
+    data += quote + "state_message" + quote + colon + quote + stateString + quote;
+    data += comma;
+    data += quote + "state_start_time" + quote + colon + startTimeString.data();
+    data += comma;
+    data += format_sequence_json( sequence );
+    data += closeBracket;
+
+    return( data );
 }
 
 
 //------------------------------------------------------------------------------------------------------------
-// loop
-//
-// The Photon executive calls this function repeatedly for the duration of the device execution. 
+// format_room_json( int group, unsigned long eventTime, unsigned long sequence )
+// 
+// Creates the event sent when the first zone in a room opens or the last one closes.  The entity id
+// is the room name with spaces turned into underscores.
 //
-// The loop mainly consists of 4 tasks.  The first is to read the input shift registers that contain
-// a bit for each zone (window, door, etc) in the system and update the zone list in memory.  The second tasks
-// looks at the updated zone list and sends a message to particle if that state of any zone has changed.  The 
-// third looks at the updated zones and adjusts the front panel LED's.  The fourth, looks at the updated
-// zones and opens or closes the circuit on a passthrough to the existing alarm system basically OR'ing
-// all the individual zones into one zone for the entire system.  Finally the last thing is a quarter second
-// delay before returning control to the executive.
+// EXAMPLE
+// {
+//    "channel_number":"ROOM",
+//    "message_type":"INFO",
+//    "entity_id":"ROOM_<room name>",
+//    "entity_display_name":"<room name> is OPEN",
+//    "open_zones":<open zones in the room>,
+//    "state_start_time":<seconds from epoch>,
+//    "seq":<n>,"event_key":"<device id>-<seq>"
+// }
 //
 //------------------------------------------------------------------------------------------------------------
 
-void loop()
+CxString format_room_json( int group, unsigned long eventTime, unsigned long sequence )
 {
+    char buffer[100];
     
-    //--------------------------------------------------------------------------------------------------------
-    // initialize all the LED bits to off, we will turn on the ones that have closed zone below 
-    // which are usually most or all of them.
-    //
-    //--------------------------------------------------------------------------------------------------------
-    for (int c=0; c<TOTAL_CHANNELS; c++) {
-        zoneLEDBits[c] = 0;
-    }
+    sprintf(buffer, "%lu", eventTime );
+    CxString startTimeString = buffer;
     
-    //--------------------------------------------------------------------------------------------------------
-    // send a heardbeat message once an hour'ish.  In mu system with my processing we can run the loop about
-    // 14248 times at 4hz.  Could do this on actual clock time if we wanted it exact.
-    //
-    //--------------------------------------------------------------------------------------------------------
-    if (++counter == 14248) {
+    sprintf(buffer, "%d", zoneGroups.openCount( group ) );
+    CxString openString = buffer;
     
-        CxString json = format_heartbeat_json();
-        Particle.publish( "access_changed" , json.data());
-        counter = 0;
+    snprintf(buffer, sizeof( buffer ), "ROOM_%s", zoneGroups.name( group ) );
+    for (char *cptr = buffer; *cptr; cptr++) {
+        if (*cptr == ' ') *cptr = '_';
     }
+    CxString entityString = buffer;
     
+    CxString messageString = zoneGroups.name( group );
+    messageString += zoneGroups.open( group ) ? " is OPEN" : " is CLOSED";
     
-    //========================================================================================================
-    //========================================================================================================
-    // loop through each of the 48 zones in the system, and update the zone list
-    //
-    //========================================================================================================
-    //========================================================================================================
-
-    // load the 48 bits into the cascade input shift register. The 48 bits represent each window or door
-    // in the house that have reed switches on them and home runned to the location of the security system
-    
-    zoneInputShiftRegister.load_latch();
+    CxString data;
+    data += openBracket;
+    data += quote + "channel_number" + quote + colon + quote + "ROOM" + quote;
+    data += comma;
+    data += quote + "message_type" + quote + colon + quote + "INFO" + quote;
+    data += comma;
+    data += quote + "entity_id" + quote + colon + quote + entityString + quote;
+    data += comma;
+    data += quote + "entity_display_name" + quote + colon + quote + messageString + quote;
+    data += comma;
+    data += quote + "open_zones" + quote + colon + openString;
+    data += comma;
+    data += quote + "state_start_time" + quote + colon + startTimeString.data();
+    data += comma;
+    data += format_sequence_json( sequence );
+    data += closeBracket;
 
-    // loop through reading each bit (zone) and updationg or zone list of objects to their new state
-    // the zone will set a flag in itself to signifiy it has changed state so we can use that in later
-    // processing to send messages and light led's
-    
-    for (int c=0; c<zoneList.entries(); c++) {
+    return( data );
+}
 
-        // read the current output bit representing the window or door 
-        // (window open == 5 volts, window closed == 0 volts)
 
-        int pinValue = zoneInputShiftRegister.readBit( );
-        
-        // get the next zone
-        
-        CxZone *zone = zoneList.at( c );
-        
-        if ( zone->configured()) {
+//------------------------------------------------------------------------------------------------------------
+// format_snapshot_json( void )
+// 
+// Creates a json blob with the full zone state, sent when asked for through "cmd snapshot"
+// so a receiver that suspects it missed something doesn't have to wait for the next heartbeat.
+//
+// EXAMPLE
+// {
+//    "channel_number":"SYSTEM",
+//    "message_type":"INFO",
+//    "entity_id":"SYSTEM_SNAPSHOT",
+//    "entity_display_name":"SYSTEM snapshot",
+//    "state_start_time":<seconds from epoch>,
+//    "configured":"<hex>",
+//    "activated":"<hex>",
+//    "last_seq":<sequence of the last event before this one>,
+//    "seq":<n>,"event_key":"<device id>-<seq>"
+// }
+//
+//------------------------------------------------------------------------------------------------------------
+
+CxString format_snapshot_json( unsigned long sequence )
+{
+    char buffer[100];
+    
+    sprintf(buffer, "%lu", Time.now() );
+    CxString startTimeString = buffer;
+
+    CxZoneSnapshot snapshot( zoneConfiguredBits, zoneActivatedBits, sequence - 1 );
+    snapshot.format( buffer, sizeof( buffer ));
+
+    CxString data;
+    data += openBracket;
+    data += quote + "channel_number" + quote + colon + quote + "SYSTEM" + quote;
+    data += comma;
+    data += quote + "message_type" + quote + colon + quote + "INFO" + quote;
+    data += comma;
+    data += quote + "entity_id" + quote + colon + quote + "SYSTEM_SNAPSHOT" + quote;
+    data += comma;
+    data += quote + "entity_display_name" + quote + colon + quote + "SYSTEM snapshot" + quote;
+    data += comma;
+    data += quote + "state_start_time" + quote + colon + startTimeString.data();
+    data += comma;
+    data += buffer;
+    data += comma;
+    data += format_sequence_json( sequence );
+    data += closeBracket;
+
+    return( data );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// configure_arming
+//
+// Splits the configured zones into perimeter and interior for the arming masks
+//
+//------------------------------------------------------------------------------------------------------------
+
+void configure_arming( void )
+{
+    uint64_t perimeterBits = 0;
+    uint64_t interiorBits  = 0;
+    uint64_t bits = zoneConfiguredBits;
+    
+    while (bits) {
+    
+        int channel = __builtin_ctzll( bits );
+        bits &= bits - 1;
         
-            // the zone is configured ( used by the system), so set the new state in the object
-            
-            if (pinValue == 1) {
-                zone->setZoneActivated( TRUE );
-            } else {
-                zone->setZoneActivated( FALSE );
-            }
-            
+        if (zoneTable[ channel ]->type() == SENSOR_MOTION) {
+            interiorBits |= (1ULL << channel);
         } else {
-            
-            // the zone is not configured (not used in the current system) so just set it to 
-            // closed state (even though its actually electically open).  These keeps you
-            // from having to jumper unused zones on the input block.
-        
-            zone->setZoneActivated( FALSE );
+            perimeterBits |= (1ULL << channel);
         }
-        
-        // shift in the next bit representing the next zone
+    }
+    
+    arming.configure( perimeterBits, interiorBits );
+}
 
-        zoneInputShiftRegister.shift();
-        
+
+//------------------------------------------------------------------------------------------------------------
+// channel_map_find
+//
+// Channel of an id in the static channel map whether or not the zone is in use, or -1.  Only for the
+// tables matched once at load, everything else goes through zoneIndex.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int channel_map_find( const char *id )
+{
+    for (int channel=0; channel<TOTAL_CHANNELS; channel++) {
+        if (strcmp( chanDef[channel][4], id ) == 0) return( channel );
     }
     
-    //========================================================================================================
-    //========================================================================================================
-    // loop through the updated zone list now that we have read in new data.  Each time we see a zone
-    // that is both configured (used in the ssystem) and changed meaning its state has changed from open
-    // to closed, or closed to open, we send a change event to the partice cloud with the new state
-    //
-    //========================================================================================================
-    //========================================================================================================
-    for (int c=0; c<zoneList.entries(); c++) {
+    return( -1 );
+}
 
-        // get the next zone 
 
-        CxZone *zone = zoneList.at( c );
+//------------------------------------------------------------------------------------------------------------
+// channel_load_list 
+//
+// loads the static config data for the system into a c++ zone array structure
+//
+//------------------------------------------------------------------------------------------------------------
+    
+void channel_load_list( void )
+{
+    char buffer[100];
+    
+    for (int channel=0; channel<TOTAL_CHANNELS; channel++) {
         
-        if ( zone->configured() ) {
+        int configured = FALSE;
+        int activated  = FALSE;
+        CxString configuredString = chanDef[channel][5];
         
-            if (zone->changed() ) {
+        if (configuredString == "ACTIVE") {
+            configured = TRUE;
+        }
 
-                // send zone state change to particle cloud
+        CxZone *zone = new CxZone(
+            channel+1,              // channel number
+            chanDef[channel][0],    // room name
+            chanDef[channel][1],    // description
+            chanDef[channel][2],    // compass location
+            chanDef[channel][3],    // sensor type
+            chanDef[channel][4],    // unique id
+            LED_MAPPING[ channel ], // where in output shift registers is that led
+            configured,
+            activated );
+            
+        zoneList.append( zone );
+        zoneTable[ channel ] = zone;
         
-                CxString json = zone->format_victorops_json();
-                Particle.publish( "access_changed" , json.data());
-            }
+        if (configured) {
+            zoneConfiguredBits |= (1ULL << channel);
+            zoneGroups.add( chanDef[channel][0], channel );
+            zoneIndex.add( chanDef[channel][4], channel );
+        }
+    }
+    
+    defaultConfiguredBits = zoneConfiguredBits;
+    
+    // compile the arming masks and delays now so the scan never looks at a string
+    
+    configure_arming( );
+    
+    // the tables are matched against the whole channel map, a zone the cloud turns on later still
+    // has its delays and schedule
+    
+    for (int d=0; d<ZONE_DELAY_COUNT; d++) {
+        int channel = channel_map_find( zoneDelays[ d ].id );
+        if (channel >= 0) {
+            arming.setDelays( channel, zoneDelays[ d ].entrySeconds, zoneDelays[ d ].exitSeconds );
+        }
+    }
+    
+    bypassSchedule.setTimeZone( SCHEDULE_TIME_ZONE, SCHEDULE_USE_DST );
+    
+    for (int e=0; e<SCHEDULE_ENTRY_COUNT; e++) {
+        int channel = channel_map_find( scheduleEntries[ e ].id );
+        if (channel >= 0) {
+            bypassSchedule.addRule( 1ULL << channel, scheduleEntries[ e ].days, 
+                                    scheduleEntries[ e ].startMinute, scheduleEntries[ e ].endMinute );
         }
     }
+    
+    bypassSchedule.compile();
+}
 
-    //========================================================================================================
-    // once again loop through the zone list and update an integer array that represents each
-    // LED on the front panel of the unit.  Each zone was loaded at startup with its bit offset into
-    // the output shift registers (they aren't 1:1 with zone mapping due to panel config and install errors
-    // in my system)
-    //
-    //========================================================================================================
-    for (int c=0; c<zoneList.entries(); c++) {
 
-        // get the next zone
+//------------------------------------------------------------------------------------------------------------
+// read_zones
+//
+// Loads the 48 bits into the cascade input shift register and shifts them in one at a time, updating
+// each zone object and the packed activated bits.  Each zone sets a flag in itself when its state
+// changed so later processing can send messages and light led's.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void read_zones( void )
+{
+    uint64_t activatedBits = 0;
+    
+    // load the 48 bits into the cascade input shift register. The 48 bits represent each window or door
+    // in the house that have reed switches on them and home runned to the location of the security system
+    
+    zoneInputShiftRegister.load_latch();
+
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+
+        // read the current output bit representing the window or door 
+        // (window open == 5 volts, window closed == 0 volts)
 
-        CxZone *zone = zoneList.at( c );
+        int pinValue = zoneInputShiftRegister.readBit( );
         
-        if (zone->configured()) {
+        CxZone *zone = zoneTable[ c ];
         
-            if (zone->activated()) {
+        if ( zone->configured() && pinValue == 1) {
+        
+            // the zone is configured ( used by the system) and open
             
-                // if the zone is activated (window open) then the green led blinks at 4hz
-
-                if (blinkState) {
-                    zoneLEDBits[ zone->ledBitPosition() ] = 0;
-                    blinkState=0;
-                } else {
-                    zoneLEDBits[ zone->ledBitPosition() ] = 1;
-                    blinkState=1;
-                }
+            zone->setZoneActivated( TRUE );
+            activatedBits |= (1ULL << c);
             
-            } else {
+        } else {
             
-                // if the zone is not activated (window closed) the green led is on
-
-                zoneLEDBits[ zone->ledBitPosition() ] = 1;
-                
-            }
+            // the zone is closed, or it is not configured (not used in the current system) so just set 
+            // it to closed state (even though its actually electically open).  These keeps you
+            // from having to jumper unused zones on the input block.
+        
+            zone->setZoneActivated( FALSE );
         }
+        
+        // shift in the next bit representing the next zone
+
+        zoneInputShiftRegister.shift();
     }
     
-    // call the function above that writes the bits out to the LED shift registers
+    zoneActivatedBits = activatedBits;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// update_live_zones
+//
+// Rewrites the "zones" variable when the activated or configured bits have changed.  The hex digits
+// are written straight from the bits inside an atomic block, so the cloud never reads a half 
+// written mask and an unchanged scan costs two compares.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void update_live_zones( int force )
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    
+    if (!force && zoneActivatedBits == liveActivatedBits && zoneConfiguredBits == liveConfiguredBits) return;
     
-    setLEDs( );
+    liveActivatedBits  = zoneActivatedBits;
+    liveConfiguredBits = zoneConfiguredBits;
     
-    //========================================================================================================
-    // once again loop through each of the 48 zones in the system, if any are open then we want to open the
-    // the solid state relay by sending zero volts to the A0 pin opening the zone circuit for
-    // the existing security system simulating a window open.
-    //
-    //========================================================================================================
+    ATOMIC_BLOCK() {
+        for (int d=0; d<LIVE_ZONE_DIGITS; d++) {
+            int shift = 4 * (LIVE_ZONE_DIGITS - 1 - d);
+            liveZonesText[ d ]                        = hexDigits[ (liveActivatedBits  >> shift) & 0xF ];
+            liveZonesText[ LIVE_ZONE_DIGITS + 1 + d ] = hexDigits[ (liveConfiguredBits >> shift) & 0xF ];
+        }
+        liveZonesText[ LIVE_ZONE_DIGITS ]         = '/';
+        liveZonesText[ 2 * LIVE_ZONE_DIGITS + 1 ] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// drive_relay
+//
+// If any configured zone is open we open the solid state relay by sending zero volts to the A0 pin,
+// opening the zone circuit for the existing security system simulating a window open.  The legacy 
+// panel does its own arming and entry delay, so the relay follows the raw zones whatever our arming 
+// mode says, the arming state worked out here only decides how events are reported.  This is 
+// called straight after read_zones() so the legacy panel never waits on publishing or the LED's.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void drive_relay( void )
+{
+    uint64_t openBits = zoneActivatedBits & zoneConfiguredBits;
     
-    int anyActivated = FALSE;
+    arming.evaluate( openBits, millis() );
+    
+    if (openBits) {
+        digitalWrite(A0, LOW);
+    } else {
+        digitalWrite(A0, HIGH);
+    }
+}
+
+
+#ifdef USE_LOOP_PROFILE
+//------------------------------------------------------------------------------------------------------------
+// render_loop_profile
+//
+// Formats the loop profile into a scratch buffer and copies it over the Particle variable in one
+// short atomic block, the cloud reads the variable from the system thread and should never see
+// a half written string.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void render_loop_profile( void )
+{
+    int len = loopProfile.formatDetail( loopProfileScratch, sizeof( loopProfileScratch ));
+    if (len >= (int) sizeof( loopProfileScratch )) len = sizeof( loopProfileScratch ) - 1;
     
-    for (int c=0; c<zoneList.entries(); c++) {
+    ATOMIC_BLOCK() {
+        memcpy( loopProfileText, loopProfileScratch, len + 1 );
+    }
+}
+#endif
+
+
+#ifdef USE_COMPACT_EVENTS
+//------------------------------------------------------------------------------------------------------------
+// flush_compact_events
+//
+// Sends the pending batch as a single access_changed event
+//
+// EXAMPLE
+// {
+//    "encoding":"zd2",            <== layout described in cxeventcodec.h, one record per transition
+//    "count":<records in the batch>,
+//    "data":"<base64 batch>",
+//    "event_key":"<device id>-<sequence of the last record>"
+// }
+//
+//------------------------------------------------------------------------------------------------------------
 
-        // get the next zone
-        CxZone *zone = zoneList.at( c );
+void flush_compact_events( void )
+{
+    char payload[ PUBLISH_DATA_MAX + 1 ];
+    
+    if (compactBatch.entries() > 0) {
+    
+        CxString key = format_event_key( compactBatch.lastSequence() );
         
-        if (zone->configured()) {
+        int len = sprintf( payload, "{\"encoding\":\"zd2\",\"count\":%d,\"data\":\"", compactBatch.entries() );
+        int tail = key.length() + 18;
+        int encoded = compactBatch.encode( payload + len, sizeof( payload ) - len - tail );
         
-            if (zone->activated()) {
-                
-                anyActivated = TRUE;
+        if (encoded > 0) {
+            sprintf( payload + len + encoded, "\",\"event_key\":\"%s\"}", key.data() );
+            if (publisher.enqueue( "access_changed", payload, compactBatch.lastSequence(), compactFirstSequence )) {
+                checkpoint.queued( compactFirstSequence, compactBatch.lastSequence() );
             }
         }
+        
+        compactBatch.reset();
     }
     
-    // if any zone in our system was found to be open, then pass that onto the existing system
-    
-    if (anyActivated) {
-        digitalWrite(A0, LOW);
-    } else {
-        digitalWrite(A0, HIGH);
+    timerWheel.cancel( compactFlushTimer );
+    compactFlushTimer = TIMER_HANDLE_NONE;
+    compactFlushDue   = FALSE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// compact_flush_expired
+//
+// Timer callback, the batch has waited long enough.  The flush itself happens back in the loop.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void compact_flush_expired( void *arg )
+{
+    compactFlushTimer = TIMER_HANDLE_NONE;
+    compactFlushDue   = TRUE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// compact_append
+//
+// Adds one zone transition to the batch with its own sequence number and severity, a full batch goes
+// out straight away.  The first record starts the timer that sends the batch.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void compact_append( unsigned long sequence, unsigned long now, uint64_t previousBits, int channel, int severity )
+{
+    if (!compactBatch.append( sequence, now, previousBits, channel, severity )) {
+        flush_compact_events( );
+        compactBatch.append( sequence, now, previousBits, channel, severity );
     }
     
+    if (compactBatch.entries() == 1) compactFirstSequence = sequence;
     
-    //========================================================================================================
-    // delay a quarter second
-    //
-    //========================================================================================================
+    if (compactFlushTimer == TIMER_HANDLE_NONE) {
+        compactFlushTimer = timerWheel.start( EVENT_CODEC_BATCH_MS, compact_flush_expired, NULL );
+        
+        // no timer to be had, send it now rather than let it sit
+        if (compactFlushTimer == TIMER_HANDLE_NONE) compactFlushDue = TRUE;
+    }
+}
+#endif
 
-    delay(250);
+
+//------------------------------------------------------------------------------------------------------------
+// zone_severity
+//
+// The message type for a zone event, from the arming state worked out in drive_relay().  Open zones
+// are CRITICAL when alarming, WARNING while the entry countdown runs and INFO when nothing is 
+// watching them.  A zone latched by an entry countdown stays CRITICAL shut or not until disarmed.
+// Returns a SEVERITY_ index into severityNames, keeps alarmReportedBits up to date.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int zone_severity( int channel, int activated )
+{
+    uint64_t bit = 1ULL << channel;
+    
+    alarmReportedBits &= ~bit;
+    
+    if (!activated && !(arming.latchedBits() & bit)) return( SEVERITY_RECOVERY );
+    if (arming.entryBits() & bit)                    return( SEVERITY_WARNING );
+    if (!(arming.alarmBits() & bit))                 return( SEVERITY_INFO );
+    
+    alarmReportedBits |= bit;
+    return( SEVERITY_CRITICAL );
 }
 
+
+//------------------------------------------------------------------------------------------------------------
+// contact_transition
+//
+// Door and window handling.  Every transition is sent unless the zone is flapping, a zone that has
+// just started flapping sends a single notice instead.  Returns TRUE if the transition should be 
+// sent.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int contact_transition( int channel, CxZone *zone, unsigned long now, unsigned long nowMillis, int *queued )
+{
+    int flap = flapDetector.transition( channel, nowMillis );
+    
+    if (flap == FLAP_STARTED) {
+    
+        unsigned long sequence = checkpoint.nextSequence();
+        
+        CxString json = format_flapping_json( zone, now, sequence );
+        publisher.enqueue( "access_changed" , json.data(), sequence );
+        (*queued)++;
+    }
+    
+    return( flap == FLAP_NONE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// motion_holdoff_expired
+//
+// Timer callback, a motion zone has been still for MOTION_HOLDOFF_MS.  publish_changes() sends its
+// state if the cloud hasn't seen it yet.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void motion_holdoff_expired( void *arg )
+{
+    int channel = (int)(intptr_t) arg;
+    
+    motionHoldoff[ channel ] = TIMER_HANDLE_NONE;
+    motionSettledBits |= (1ULL << channel);
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// motion_transition
+//
+// Motion detectors open and close on every retrigger.  The first transition after a quiet spell is
+// sent and starts a holdoff, anything inside the holdoff just pushes it back.  A burst of activity 
+// therefore costs one event at the start and, once things are still, one at the end.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int motion_transition( int channel, CxZone *zone, unsigned long now, unsigned long nowMillis, int *queued )
+{
+    int quiet = (motionHoldoff[ channel ] == TIMER_HANDLE_NONE);
+    
+    timerWheel.cancel( motionHoldoff[ channel ] );
+    motionHoldoff[ channel ] = timerWheel.start( MOTION_HOLDOFF_MS, motion_holdoff_expired, (void *)(intptr_t) channel );
+    
+    return( quiet );
+}
+
+
+// per sensor type transition handling, indexed by CxSensorType
+ZoneTransitionHandler zoneTransitionHandlers[ SENSOR_TYPES ] = {
+    contact_transition,         // SENSOR_UNKNOWN
+    contact_transition,         // SENSOR_DOOR
+    contact_transition,         // SENSOR_WINDOW
+    motion_transition           // SENSOR_MOTION
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// render_rooms
+//
+// Formats the open count of every room and copies it over the "rooms" Particle variable in one 
+// short atomic block, the same way the loop profile is published.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void render_rooms( void )
+{
+    int len = zoneGroups.format( roomsScratch, sizeof( roomsScratch ));
+    if (len >= (int) sizeof( roomsScratch )) len = sizeof( roomsScratch ) - 1;
+    
+    ATOMIC_BLOCK() {
+        memcpy( roomsText, roomsScratch, len );
+        roomsText[ len ] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// update_status
+//
+// Re-renders the "status" variable when the mode, the open, alarming or bypassed zones, or the entry
+// countdown have changed since it was last rendered, otherwise costs a compare.
+//
+// EXAMPLE
+// {"mode":"AWAY","open":"<hex>","alarm":"<hex>","entry":"<hex>","bypassed":"<hex>","rooms_open":<n>}
+//
+//------------------------------------------------------------------------------------------------------------
+
+void update_status( int force )
+{
+    StatusKey key;
+    char open[17], alarm[17], entry[17], bypassed[17];
+    
+    memset( &key, 0, sizeof( key ));
+    key.openBits   = zoneReportedBits;
+    key.alarmBits  = arming.alarmBits();
+    key.entryBits  = arming.entryBits();
+    key.bypassBits = arming.bypassBits();
+    key.mode       = arming.mode();
+    
+    if (!force && memcmp( &key, &statusKey, sizeof( key )) == 0) return;
+    statusKey = key;
+    
+    int roomsOpen = 0;
+    for (int g=0; g<zoneGroups.groups(); g++) {
+        roomsOpen += zoneGroups.open( g );
+    }
+    
+    CxZoneSnapshot::formatHex( key.openBits, open );
+    CxZoneSnapshot::formatHex( key.alarmBits, alarm );
+    CxZoneSnapshot::formatHex( key.entryBits, entry );
+    CxZoneSnapshot::formatHex( key.bypassBits, bypassed );
+    
+    int len = snprintf( statusScratch, sizeof( statusScratch ), 
+                        "{\"mode\":\"%s\",\"open\":\"%s\",\"alarm\":\"%s\",\"entry\":\"%s\",\"bypassed\":\"%s\",\"rooms_open\":%d}",
+                        CxArming::modeName( key.mode ), open, alarm, entry, bypassed, roomsOpen );
+    if (len >= (int) sizeof( statusScratch )) len = sizeof( statusScratch ) - 1;
+    
+    ATOMIC_BLOCK() {
+        memcpy( statusText, statusScratch, len );
+        statusText[ len ] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// collect_outcomes
+//
+// drop transitions the cloud has accepted from the checkpoint backlog, anything abandoned stays and is
+// sent again by resend_checkpoint_backlog()
+//
+//------------------------------------------------------------------------------------------------------------
+
+void collect_outcomes( void )
+{
+    unsigned long outcomeFirst, outcomeLast;
+    int           published;
+    
+    while (publisher.nextOutcome( &outcomeFirst, &outcomeLast, &published )) {
+        if (published) {
+            checkpoint.completed( outcomeFirst, outcomeLast );
+        } else {
+            checkpoint.abandoned( outcomeFirst, outcomeLast );
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// publish_changes
+//
+// loop through the updated zone list now that we have read in new data.  Each time we see a zone
+// that is both configured (used in the ssystem) and changed meaning its state has changed from open
+// to closed, or closed to open, we send a change event to the partice cloud with the new state.
+// Returns the number of events queued.
+//
+// Zones that are flapping are kept off the air apart from one notice, motion zones are quiet while
+// their holdoff runs.  Once such a zone settles its state is sent if it differs from the last state
+// the cloud was told about.
+//
+// Like the restart message nothing is sent until the cloud has set the clock, every event is stamped
+// with Time.now().  The first pass after that treats every zone as settled, so anything that moved
+// meanwhile goes out with its state as it is now.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int publish_changes( void )
+{
+    if (!Time.isValid()) {
+        clockHeld = TRUE;
+        collect_outcomes( );
+        return( 0 );
+    }
+    
+    int queued = 0;
+    unsigned long now       = Time.now();
+    unsigned long nowMillis = millis();
+    
+    uint64_t settledBits  = flapDetector.expire( nowMillis ) | motionSettledBits;
+    uint32_t roomBits     = 0;
+    
+    motionSettledBits = 0;
+    
+    if (clockHeld) {
+        settledBits |= ~flapDetector.flappingBits();
+        clockHeld    = FALSE;
+    }
+    
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+
+        // get the next zone 
+
+        CxZone *zone = zoneTable[ c ];
+        
+        if ( zone->configured() ) {
+        
+            int report = FALSE;
+            
+            if (zone->changed() ) {
+
+                // the local records see every transition, flapping or not
+                
+                zoneStats.record( c, zone->activated(), nowMillis, now );
+                history.append( now, c, zone->activated() );
+                
+                // what to do with it depends on the kind of sensor
+                
+                report = zoneTransitionHandlers[ zone->type() ]( c, zone, now, nowMillis, &queued );
+            }
+            
+            if ((settledBits >> c) & 1) {
+                report = (((zoneReportedBits >> c) & 1) != (uint64_t)(zone->activated() ? 1 : 0));
+            }
+            
+            if (report) {
+
+                // checkpoint the transition with the state the cloud now has, then queue the zone 
+                // state change for the publisher thread to send to particle cloud.  A zone held back
+                // while flapping or in a motion holdoff isn't in the checkpoint until it is sent
+        
+                zoneReportedBits ^= (1ULL << c);
+                
+                int           severity = zone_severity( c, zone->activated() );
+                unsigned long sequence = checkpoint.recordTransition( c, zone->activated(), severity, now, zoneReportedBits );
+                roomBits |= zoneGroups.transition( c, zone->activated() );
+                
+#ifdef USE_COMPACT_EVENTS
+                compact_append( sequence, now, zoneReportedBits ^ (1ULL << c), c, severity );
+#else
+                CxString json = zone->format_victorops_json( zone->activated(), now, sequence, 
+                                                             format_event_key( sequence ).data(), 
+                                                             severityNames[ severity ] );
+                if (publisher.enqueue( "access_changed" , json.data(), sequence )) {
+                    checkpoint.queued( sequence, sequence );
+                }
+#endif
+                queued++;
+            }
+        }
+    }
+    
+#ifndef USE_COMPACT_EVENTS
+    // zones that started alarming without changing, an entry countdown that ran out or a mode change
+    // with the zone already open, are sent again as CRITICAL.  An entry zone latched by the countdown
+    // alarms even if it was shut again before it ran out
+    
+    uint64_t escalatedBits = arming.alarmBits() & (zoneReportedBits | arming.latchedBits()) & ~alarmReportedBits;
+    
+    while (escalatedBits) {
+    
+        int c = __builtin_ctzll( escalatedBits );
+        escalatedBits &= escalatedBits - 1;
+        
+        int           open     = (zoneReportedBits >> c) & 1;
+        unsigned long sequence = checkpoint.nextSequence();
+        int           severity = zone_severity( c, open );
+        
+        CxString json = zoneTable[ c ]->format_victorops_json( open, now, sequence, 
+                                                               format_event_key( sequence ).data(), 
+                                                               severityNames[ severity ] );
+        publisher.enqueue( "access_changed" , json.data(), sequence );
+        queued++;
+    }
+    
+    // a latched zone that is already shut recovers when disarming releases it
+    
+    uint64_t releasedBits = alarmReportedBits & ~arming.alarmBits() & ~zoneReportedBits;
+    
+    while (releasedBits) {
+    
+        int c = __builtin_ctzll( releasedBits );
+        releasedBits &= releasedBits - 1;
+        
+        unsigned long sequence = checkpoint.nextSequence();
+        int           severity = zone_severity( c, FALSE );
+        
+        CxString json = zoneTable[ c ]->format_victorops_json( FALSE, now, sequence, 
+                                                               format_event_key( sequence ).data(), 
+                                                               severityNames[ severity ] );
+        publisher.enqueue( "access_changed" , json.data(), sequence );
+        queued++;
+    }
+#endif
+    
+#ifdef USE_COMPACT_EVENTS
+    if (compactFlushDue) {
+        flush_compact_events( );
+    }
+#endif
+    
+    // rooms whose first zone opened or last zone closed
+    
+    if (roomBits) {
+    
+#ifdef USE_ROOM_EVENTS
+        uint32_t bits = roomBits;
+        
+        while (bits) {
+        
+            int g = __builtin_ctzl( bits );
+            bits &= bits - 1;
+            
+            unsigned long sequence = checkpoint.nextSequence();
+            
+            CxString json = format_room_json( g, now, sequence );
+            publisher.enqueue( "access_changed" , json.data(), sequence );
+            queued++;
+        }
+#endif
+        render_rooms( );
+    }
+    
+    collect_outcomes( );
+    
+    return( queued );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// update_leds
+//
+// Picks the pattern for each zone's LED on the front panel: steady when closed, fast blink when open,
+// slow blink while the zone is flapping and dim when it is bypassed.  The LED engine does the actual
+// refresh from its timer, so this only writes a byte per zone.  Each zone was loaded at startup with
+// its bit offset into the output shift registers (they aren't 1:1 with zone mapping due to panel 
+// config and install errors in my system)
+//
+//------------------------------------------------------------------------------------------------------------
+
+void update_leds( void )
+{
+    uint64_t flappingBits = flapDetector.flappingBits();
+    uint64_t bypassBits   = arming.bypassBits();
+    
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+
+        CxZone  *zone    = zoneTable[ c ];
+        uint64_t bit     = 1ULL << c;
+        int      pattern = LED_OFF;
+        
+        if (zone->configured()) {
+        
+            if (flappingBits & bit) {
+                pattern = LED_SLOW_BLINK;
+            } else if (zone->activated()) {
+                pattern = LED_FAST_BLINK;
+            } else if (bypassBits & bit) {
+                pattern = LED_DIM;
+            } else {
+                pattern = LED_STEADY;
+            }
+        }
+        
+        ledEngine.setPattern( zone->ledBitPosition(), pattern );
+    }
+    
+    ledFrameUs = (int) ledEngine.maxFrameMicros();
+    ledShifts  = (int) ledEngine.shifts();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// restore_checkpoint
+//
+// After a reset that kept power the retained checkpoint still holds the state the cloud was last 
+// told for every zone.  Putting that back before the first scan means only zones that really changed
+// while we were down, or were being held back, generate events, instead of a fresh CRITICAL for every
+// open zone.  Runs after the arming mode is restored.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void restore_checkpoint( void )
+{
+    if (!checkpoint.restore( TOTAL_CHANNELS, zoneConfiguredBits )) {
+        return;
+    }
+    
+    zoneActivatedBits = checkpoint.activatedBits();
+    
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+        zoneTable[ c ]->restoreActivated( (zoneActivatedBits >> c) & 1 ? TRUE : FALSE );
+    }
+    
+    // the open zones that alarm were sent as CRITICAL before the reset, or are in the backlog waiting
+    // to be sent again, so the first scan mustn't escalate them as if they had just started alarming
+    
+    alarmReportedBits = arming.evaluate( zoneActivatedBits & zoneConfiguredBits, millis() );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// resend_checkpoint_backlog
+//
+// Transitions in the checkpoint backlog that aren't with the publisher are queued again with their 
+// original sequence number, time and message type.  At startup that is whatever wasn't confirmed before the reset,
+// after that it is any event that was dropped on a full queue or abandoned by the publisher.  Stops
+// while the queue is full rather than count drops.  Returns the number queued.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int resend_checkpoint_backlog( void )
+{
+    int resent = 0;
+    
+    for (int i=0; i<checkpoint.backlogEntries(); i++) {
+    
+        const CxCheckpointEvent *event = checkpoint.backlogAt( i );
+        
+        if (event->flags & CHECKPOINT_QUEUED) continue;
+        
+#ifdef USE_COMPACT_EVENTS
+        // still waiting in the batch
+        if (compactBatch.entries() && (int32_t)(event->sequence - compactFirstSequence) >= 0) continue;
+#endif
+        
+        if (publisher.depth() >= PUBLISH_QUEUE_DEPTH) break;
+        
+        CxZone     *zone     = zoneTable[ event->channel ];
+        const char *severity = (event->severity < SEVERITY_COUNT) ? severityNames[ event->severity ] : NULL;
+        
+        CxString json = zone->format_victorops_json( event->activated, event->time, event->sequence,
+                                                     format_event_key( event->sequence ).data(), severity );
+        
+        if (!publisher.enqueue( "access_changed" , json.data(), event->sequence )) break;
+        
+        checkpoint.queued( event->sequence, event->sequence );
+        resent++;
+    }
+    
+    return( resent );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// mark_startup
+//
+// Records how long after reset a startup stage finished
+//
+//------------------------------------------------------------------------------------------------------------
+
+void mark_startup( int stage )
+{
+    startupMicros[ stage ] = micros();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// apply_config
+//
+// Brings the live zone tables in line with the channel map plus the overrides in config, touching
+// only the zones that differ.  A zone taken out of use while the cloud has it open is sent a 
+// RECOVERY and closed in its room, and its flap and motion holdoff state is dropped.  A zone put 
+// into use starts closed and the next scan reports it if it is open.
+// Runs between scans from the loop thread, the cost is one pass over the channels plus a string
+// copy for each renamed zone, and it is timed into configApplyUs.  Returns the number of zones
+// changed.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int apply_config( CxConfigBlob *config )
+{
+    unsigned long start = micros();
+    
+    uint64_t    targetBits = defaultConfiguredBits;
+    const char *description[ TOTAL_CHANNELS ];
+    int         descriptionLength[ TOTAL_CHANNELS ];
+    
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+        description[ c ]       = chanDef[c][1];
+        descriptionLength[ c ] = strlen( chanDef[c][1] );
+    }
+    
+    CxConfigRecord record;
+    
+    for (int more = config->first( &record ); more; more = config->next( &record )) {
+    
+        if (record.active) {
+            targetBits |= (1ULL << record.channel);
+        } else {
+            targetBits &= ~(1ULL << record.channel);
+        }
+        
+        if (record.description != NULL) {
+            description[ record.channel ]       = record.description;
+            descriptionLength[ record.channel ] = record.descriptionLength;
+        }
+    }
+    
+    uint64_t changedBits = targetBits ^ zoneConfiguredBits;
+    int      changes     = 0;
+    
+    for (int c=0; c<TOTAL_CHANNELS; c++) {
+        if (zoneTable[ c ]->setDescription( description[ c ], descriptionLength[ c ] )) changes++;
+    }
+    
+    while (changedBits) {
+    
+        int c = __builtin_ctzll( changedBits );
+        changedBits &= changedBits - 1;
+        
+        uint64_t bit = 1ULL << c;
+        
+        if (targetBits & bit) {
+            zoneGroups.add( chanDef[c][0], c );
+            zoneIndex.add( chanDef[c][4], c );
+        } else {
+        
+            // the cloud has the zone open, close its incident before the zone goes quiet
+            
+            if (zoneReportedBits & bit) {
+            
+                zoneReportedBits &= ~bit;
+                zoneGroups.transition( c, FALSE );
+                
+                unsigned long now      = Time.now();
+                int           severity = zone_severity( c, FALSE );
+                unsigned long sequence = checkpoint.recordTransition( c, FALSE, severity, now, zoneReportedBits );
+                
+                CxString json = zoneTable[ c ]->format_victorops_json( FALSE, now, sequence, 
+                                                                       format_event_key( sequence ).data(), 
+                                                                       severityNames[ severity ] );
+                if (publisher.enqueue( "access_changed" , json.data(), sequence )) {
+                    checkpoint.queued( sequence, sequence );
+                }
+            }
+            
+            zoneGroups.remove( c );
+            
+            // nothing left over to report when the zone comes back
+            
+            flapDetector.clear( c );
+            timerWheel.cancel( motionHoldoff[ c ] );
+            motionHoldoff[ c ] = TIMER_HANDLE_NONE;
+            motionSettledBits &= ~bit;
+            
+            alarmReportedBits &= ~bit;
+            zoneActivatedBits &= ~bit;
+        }
+        
+        zoneTable[ c ]->setConfigured( (targetBits & bit) ? TRUE : FALSE );
+        changes++;
+    }
+    
+    if (zoneConfiguredBits != targetBits) {
+        zoneConfiguredBits = targetBits;
+        configure_arming( );
+        render_rooms( );
+    }
+    
+    configApplyUs = (int)(micros() - start);
+    
+    return( changes );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// find_zone
+//
+// Channel index of the zone with the given id (K_W_W), or -1.  With len >= 0 the id is the first len 
+// characters of a longer argument, so callers never have to copy it out.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int find_zone( const char *id, int len )
+{
+    return( zoneIndex.find( id, len ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// zone_argument
+//
+// Channel index for a command argument holding a zone id (K_W_W) or a channel index, or -1
+//
+//------------------------------------------------------------------------------------------------------------
+
+int zone_argument( const CxToken& token )
+{
+    long number;
+    
+    if (token.toLong( &number )) {
+        if (number >= 0 && number < TOTAL_CHANNELS) return( (int) number );
+        return( -1 );
+    }
+    
+    return( find_zone( token.data(), token.length() ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// history_append_json
+//
+// CxHistory handler, adds [time,channel,activated] to historyText
+//
+//------------------------------------------------------------------------------------------------------------
+
+void history_append_json( unsigned long time, int channel, int activated, void *arg )
+{
+    int room = sizeof( historyText ) - historyTextLength - 1;     // leave room for the closing bracket
+    
+    int len = snprintf( historyText + historyTextLength, room, "%s[%lu,%d,%d]", 
+                        historyTextLength > 1 ? "," : "", time, channel, activated );
+    
+    if (len < room) historyTextLength += len;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// publish_mode
+//
+// Queues a SYSTEM_MODE event with the current mode and bypassed zones
+//
+//------------------------------------------------------------------------------------------------------------
+
+void publish_mode( void )
+{
+    unsigned long sequence = checkpoint.nextSequence();
+    
+    CxString json = format_mode_json( sequence );
+    publisher.enqueue( "access_changed" , json.data(), sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// publish_snapshot
+//
+// Queues a SYSTEM_SNAPSHOT event, returns the queue result
+//
+//------------------------------------------------------------------------------------------------------------
+
+int publish_snapshot( void )
+{
+    unsigned long sequence = checkpoint.nextSequence();
+    
+    CxString json = format_snapshot_json( sequence );
+    return( publisher.enqueue( "access_changed" , json.data(), sequence ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_status
+//
+// "status", the status variable is kept rendered by update_status() so there is nothing to format
+// here.  Returns the number of open zones.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_status( CxTokenizer *args )
+{
+    return( __builtin_popcountll( zoneReportedBits ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_zone
+//
+// "zone <zone id|channel>", returns the zone's state as bits, 1 open, 2 bypassed, 4 alarming, or -1
+// if no zone matched
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_zone( CxTokenizer *args )
+{
+    CxToken token;
+    args->next( &token );
+    
+    int channel = zone_argument( token );
+    if (channel < 0) return( -1 );
+    
+    uint64_t bit = 1ULL << channel;
+    int state = 0;
+    
+    if (zoneReportedBits & bit)      state |= 1;
+    if (arming.bypassBits() & bit)   state |= 2;
+    if (arming.alarmBits() & bit)    state |= 4;
+    
+    return( state );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_stats
+//
+// "stats <zone id|channel>", leaves the zone's figures in the zoneStats variable.  Returns the number 
+// of times the zone has opened, or -1 if no zone matched.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_stats( CxTokenizer *args )
+{
+    CxToken token;
+    args->next( &token );
+    
+    int channel = zone_argument( token );
+    if (channel < 0) return( -1 );
+    
+    zoneStats.format( channel, zoneStatsText, sizeof( zoneStatsText ), millis() );
+    
+    return( (int) zoneStats.entry( channel )->opens );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_history
+//
+// "history [<zone id>] <count>", the latest transitions of every zone or of one zone, at most 
+// HISTORY_QUERY_MAX.  The transitions are left oldest first in the history variable as 
+// [[time,channel,activated],...].  Returns the number found, or -1 if the zone id didn't match.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_history( CxTokenizer *args )
+{
+    CxToken token;
+    int channel = HISTORY_ALL_ZONES;
+    long count  = HISTORY_QUERY_MAX;
+    
+    args->next( &token );
+    
+    if (!token.isNull() && !token.toLong( &count )) {
+    
+        channel = find_zone( token.data(), token.length() );
+        if (channel < 0) return( -1 );
+        
+        args->next( &token );
+        token.toLong( &count );
+    }
+    
+    if (count <= 0 || count > HISTORY_QUERY_MAX) count = HISTORY_QUERY_MAX;
+    
+    historyText[0] = '[';
+    historyTextLength = 1;
+    
+    int found = history.last( (int) count, channel, history_append_json, NULL );
+    
+    historyText[ historyTextLength++ ] = ']';
+    historyText[ historyTextLength ] = 0;
+    
+    return( found );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_room
+//
+// "room <room name>", the name as it appears in the channel map (Family Room).  Returns the number of
+// open zones in the room, -1 if there is no such room.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_room( CxTokenizer *args )
+{
+    int group = zoneGroups.find( args->rest() );
+    if (group == GROUP_NONE) return( -1 );
+    
+    return( zoneGroups.openCount( group ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_mode
+//
+// "mode <DISARMED|STAY|AWAY>".  Returns the new mode (0, 1, 2) or -1 if the argument isn't a mode.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_mode( CxTokenizer *args )
+{
+    CxToken token;
+    args->next( &token );
+    
+    for (int mode=0; mode<ARM_MODES; mode++) {
+    
+        if (token.equals( CxArming::modeName( mode ))) {
+        
+            arming.setMode( mode, millis() );
+            
+            publish_mode( );
+            return( mode );
+        }
+    }
+    
+    return( -1 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_bypass
+//
+// "bypass <zone id> [0]", bypasses a zone or with 0 puts it back.  Returns 1 if the zone is now 
+// bypassed, 0 if not, -1 if the zone id didn't match.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_bypass( CxTokenizer *args )
+{
+    CxToken token;
+    long bypass = TRUE;
+    
+    args->next( &token );
+    int channel = find_zone( token.data(), token.length() );
+    if (channel < 0) return( -1 );
+    
+    args->next( &token );
+    token.toLong( &bypass );
+    
+    arming.setBypass( channel, bypass ? TRUE : FALSE );
+    
+    publish_mode( );
+    return( bypass ? TRUE : FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_heartbeat
+//
+// "heartbeat <interval seconds> [<jitter seconds>]", restarts the heartbeat schedule from now.  
+// Returns the interval in seconds, or -1 if it wasn't understood.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_heartbeat( CxTokenizer *args )
+{
+    CxToken token;
+    long intervalSeconds;
+    long jitterSeconds = 0;
+    
+    args->next( &token );
+    if (!token.toLong( &intervalSeconds ) || intervalSeconds < 10) return( -1 );
+    
+    if (args->next( &token )) {
+        if (!token.toLong( &jitterSeconds ) || jitterSeconds < 0) return( -1 );
+    }
+    
+    heartbeatSchedule.setInterval( millis(), intervalSeconds * 1000UL, jitterSeconds * 1000UL );
+    
+    return( (int) intervalSeconds );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_snapshot
+//
+// "snapshot", queues a SYSTEM_SNAPSHOT event.  Returns the queue result so the caller can tell when
+// the request was dropped.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_snapshot( CxTokenizer *args )
+{
+    return( publish_snapshot( ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_config
+//
+// "config <base64 blob>" validates a configuration blob (layout in cxconfigblob.h), applies it over
+// the channel map and keeps it in EEPROM.  "config default" goes back to the channel map as 
+// compiled.  Returns the number of zones changed, or a CONFIG_ error if the blob was refused, in 
+// which case nothing changes.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_config( CxTokenizer *args )
+{
+    CxToken token;
+    args->next( &token );
+    
+    if (token.equals( "default" )) {
+        zoneConfig.clear();
+    } else {
+        int result = zoneConfig.decode( token.data() );
+        if (result != CONFIG_OK) {
+            zoneConfig.load();
+            return( result );
+        }
+    }
+    
+    zoneConfig.save();
+    
+    // the checkpoint follows the new zone set or the next reset would throw it away, and the 
+    // snapshot carries the new configured bits
+    
+    int changes = apply_config( &zoneConfig );
+    checkpoint.reconfigure( zoneConfiguredBits, zoneReportedBits );
+    if (changes > 0) publish_snapshot( );
+    
+    return( changes );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// cmd_selftest
+//
+// "selftest", runs the input chain self test again and sets the chain delay from it.  Returns the
+// delay in microseconds, or minus the CHAIN_ fault, in which case the chain is back on the stock
+// delay.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int cmd_selftest( CxTokenizer *args )
+{
+    int fault = chainTest.run( &zoneInputShiftRegister, TOTAL_CHANNELS );
+    if (fault != CHAIN_OK) return( -fault );
+    
+    return( chainTest.inputDelay( ));
+}
+
+
+// the commands taken by the "cmd" function
+typedef int (*CommandHandler)( CxTokenizer *args );
+
+struct Command {
+    const char     *name;
+    CommandHandler  handler;
+};
+
+#define COMMAND_COUNT 11
+Command commands[ COMMAND_COUNT ] = {
+    { "status",    cmd_status    },
+    { "zone",      cmd_zone      },
+    { "stats",     cmd_stats     },
+    { "history",   cmd_history   },
+    { "room",      cmd_room      },
+    { "mode",      cmd_mode      },
+    { "bypass",    cmd_bypass    },
+    { "heartbeat", cmd_heartbeat },
+    { "snapshot",  cmd_snapshot  },
+    { "config",    cmd_config    },
+    { "selftest",  cmd_selftest  }
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// run_command
+//
+// Particle function "cmd", takes "<command> <arguments>" with the arguments separated by spaces or 
+// commas, "bypass K_W_W,0" and "bypass K_W_W 0" are the same thing.  The command line is parsed in 
+// place, tokens point into the argument itself.  Returns what the command returns, -2 for a command
+// that doesn't exist.
+//
+//------------------------------------------------------------------------------------------------------------
+
+int run_command( String arg )
+{
+    CxTokenizer args( arg.c_str(), " ," );
+    CxToken     name;
+    
+    args.next( &name );
+    
+    for (int c=0; c<COMMAND_COUNT; c++) {
+        if (name.equals( commands[ c ].name )) return( commands[ c ].handler( &args ));
+    }
+    
+    return( -2 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// setup
+//
+// The Photon runtime executive calls this function once after device reset.  With the system thread
+// enabled it runs before the cloud is connected, so the house is protected from the first scan on.
+// Startup happens in a measured order:
+//
+//   1) pins and the shift register interfaces
+//   2) the zone list, from the static channel map and the configuration saved in EEPROM
+//   3) the retained checkpoint, if the reset kept power
+//   4) the first chain read and relay decision
+//   5) the first LED refresh
+//   6) the input chain self test, which sets the chain delay
+//   7) cloud facing work: variables, the publisher thread, resending the checkpoint backlog and 
+//      queueing the first scan's transitions once the clock is set
+//
+// The restart message and the zone events wait in loop() until the clock has been set by the cloud,
+// so publish_changes() here only queues the first scan's transitions if the clock is already valid.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+    pinMode(A0, OUTPUT);
+    digitalWrite(A0, HIGH);
+    
+    zoneInputShiftRegister.begin( 
+        D2,    // Connects to Parallel load pin the 165
+        D1,    // Connects to Clock Enable pin the 165
+        D0,    // Connects to the Q7 pin the 165
+        D3 );  // Connects to the data pin
+        
+    LEDOutputShiftRegister.begin(
+        D6,    // Connects to SHCP pin
+        D5,    // Connects to STCP pin
+        D4 );  // Connects to DS pin
+    
+    mark_startup( STARTUP_PINS );
+    
+    // load the channel map and any configuration saved over it
+    channel_load_list( );
+    if (zoneConfig.load() == CONFIG_OK) {
+        apply_config( &zoneConfig );
+    }
+    arming.restore( ARM_AWAY );
+    mark_startup( STARTUP_ZONES );
+    
+    // pick up zone state from before the reset if the checkpoint is good
+    restore_checkpoint( );
+    zoneStats.begin( zoneActivatedBits, millis() );
+    zoneReportedBits = zoneActivatedBits;
+    zoneGroups.begin( zoneReportedBits );
+    render_rooms( );
+    mark_startup( STARTUP_RESTORE );
+    
+    // first scan, protect the house before anything else
+    read_zones( );
+    drive_relay( );
+    mark_startup( STARTUP_FIRST_SCAN );
+    
+    update_leds( );
+    ledEngine.begin( );
+    mark_startup( STARTUP_FIRST_LEDS );
+    
+    // the relay is already protecting the house, so the chain can be tested before the cloud
+    chainTest.run( &zoneInputShiftRegister, TOTAL_CHANNELS );
+    mark_startup( STARTUP_SELF_TEST );
+    
+    timeToFirstScanUs = (int) startupMicros[ STARTUP_FIRST_SCAN ];
+    
+    // now the cloud facing work
+    
+    deviceId = System.deviceID().c_str();
+    
+    Particle.variable( "relayLatUs", &relayLatencyUs );
+    Particle.variable( "relayMaxUs", &relayLatencyMaxUs );
+    Particle.variable( "firstScanUs", &timeToFirstScanUs );
+    
+    update_live_zones( TRUE );
+    liveSequence = (int) checkpoint.sequence();
+    Particle.variable( "zones", liveZonesText );
+    Particle.variable( "seq", &liveSequence );
+    Particle.variable( "loops", &counter );
+    Particle.variable( "loopUs", &loopUs );
+    Particle.variable( "loopMaxUs", &loopMaxUs );
+    Particle.variable( "configUs", &configApplyUs );
+    Particle.variable( "ledFrameUs", &ledFrameUs );
+    Particle.variable( "ledShifts", &ledShifts );
+    
+    // every remote command goes through "cmd", the variables hold what the commands leave behind
+    
+    Particle.function( "cmd", run_command );
+    
+    update_status( TRUE );
+    Particle.variable( "status", statusText );
+    
+    zoneStatsText[0] = 0;
+    Particle.variable( "zoneStats", zoneStatsText );
+    
+    strcpy( historyText, "[]" );
+    Particle.variable( "history", historyText );
+    
+    Particle.variable( "rooms", roomsText );
+    
+#ifdef USE_LOOP_PROFILE
+    loopProfileText[0] = 0;
+    Particle.variable( "loopProfile", loopProfileText );
+#endif
+    
+    timerWheel.begin( millis() );
+    heartbeatSchedule.begin( millis(), HEARTBEAT_INTERVAL_MS, HEARTBEAT_JITTER_MS );
+    
+#ifdef USE_LOOP_PROFILE
+    profileRenderSchedule.begin( millis(), PROFILE_RENDER_MS );
+#endif
+    
+    if (!publisher.begin()) {
+        publisherFailed = TRUE;
+    }
+    
+    checkpointResent = resend_checkpoint_backlog( );
+    publish_changes( );
+    
+    mark_startup( STARTUP_CLOUD );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// loop
+//
+// The Photon executive calls this function repeatedly for the duration of the device execution. 
+//
+// The loop mainly consists of 4 tasks.  The first is to read the input shift registers that contain
+// a bit for each zone (window, door, etc) in the system and update the zone list in memory.  The second, done
+// immediately after the read, opens or closes the circuit on a passthrough to the existing alarm system
+// basically OR'ing all the individual zones into one zone for the entire system.  The third looks at the
+// updated zone list and sends a message to particle if that state of any zone has changed.  The fourth
+// looks at the updated zones and adjusts the front panel LED's.  Finally the last thing is a quarter second
+// delay before returning control to the executive.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+    
+    //========================================================================================================
+    //========================================================================================================
+    // read each of the 48 zones in the system and drive the passthrough relay before doing anything
+    // else.  Nothing below (publishing, LED's, timers) can delay the existing alarm system.
+    //
+    //========================================================================================================
+    //========================================================================================================
+
+    PROFILE_START( loopProfile, PHASE_LOOP );
+    
+#ifdef USE_HEAP_STATS
+    // count every allocation made during this pass, a pass that sends nothing should make none
+    int steadyState = TRUE;
+    CxHeapStats::beginIteration();
+#endif
+    
+    unsigned long scanStart = micros();
+    
+    PROFILE_START( loopProfile, PHASE_SCAN );
+    read_zones( );
+    PROFILE_STOP( loopProfile, PHASE_SCAN );
+    
+    PROFILE_START( loopProfile, PHASE_RELAY );
+    drive_relay( );
+    PROFILE_STOP( loopProfile, PHASE_RELAY );
+    
+    relayLatencyUs = (int)(micros() - scanStart);
+    if (relayLatencyUs > relayLatencyMaxUs) {
+        relayLatencyMaxUs = relayLatencyUs;
+    }
+    
+    update_live_zones( FALSE );
+    
+    //--------------------------------------------------------------------------------------------------------
+    // run any timers that have come due since the last pass through the loop
+    //
+    //--------------------------------------------------------------------------------------------------------
+    PROFILE_START( loopProfile, PHASE_TIMERS );
+    timerWheel.advance( millis() );
+    
+    // the bypass schedule is only looked at when its next change is due, takes effect next scan
+    
+    if (Time.isValid() && bypassSchedule.due( Time.now() )) {
+        arming.setScheduledBypass( bypassSchedule.evaluate( Time.now() ));
+    }
+    PROFILE_STOP( loopProfile, PHASE_TIMERS );
+    
+    PROFILE_START( loopProfile, PHASE_PUBLISH );
+    
+    //--------------------------------------------------------------------------------------------------------
+    // without a publisher queue no event can reach the cloud, this is the one publish made from loop()
+    //
+    //--------------------------------------------------------------------------------------------------------
+    if (publisherFailed && Particle.connected()) {
+        Particle.publish( "publisher_failed", "queue could not be created, no events will be sent" );
+        publisherFailed = FALSE;
+    }
+    
+    //--------------------------------------------------------------------------------------------------------
+    // the restart message is held back until the cloud has set the clock so its time stamp is right
+    //
+    //--------------------------------------------------------------------------------------------------------
+    if (restartPending && Time.isValid()) {
+    
+        unsigned long sequence = checkpoint.nextSequence();
+        
+        CxString json = format_restart_json( sequence );
+        publisher.enqueue( "access_changed" , json.data(), sequence );
+        restartPending = FALSE;
+        
+#ifdef USE_HEAP_STATS
+        steadyState = FALSE;
+#endif
+    }
+    
+    //--------------------------------------------------------------------------------------------------------
+    // send a heartbeat message once an hour, timed on millis() so it doesn't depend on how long each
+    // pass through the loop takes.  counter tells the cloud how many passes fit in the interval.
+    //
+    //--------------------------------------------------------------------------------------------------------
+    counter++;
+    
+    if (heartbeatSchedule.due( millis() )) {
+    
+        unsigned long sequence = checkpoint.nextSequence();
+        
+        CxString json = format_heartbeat_json( sequence );
+        publisher.enqueue( "access_changed" , json.data(), sequence );
+        counter   = 0;
+        loopMaxUs = 0;
+        
+#ifdef USE_LOOP_PROFILE
+        // each heartbeat reports the timings since the one before
+        loopProfile.reset();
+#endif
+
+#ifdef USE_HEAP_STATS
+        CxHeapStats::resetWindow();
+        steadyState = FALSE;
+#endif
+    }
+    
+    //========================================================================================================
+    // send an event for every zone that changed state
+    //
+    //========================================================================================================
+    int queued = publish_changes( );
+    
+    // transitions whose event was dropped or abandoned go out again
+    queued += resend_checkpoint_backlog( );
+    
+    if (queued > 0) {
+#ifdef USE_HEAP_STATS
+        steadyState = FALSE;
+#endif
+    }
+    
+    update_status( FALSE );
+    liveSequence = (int) checkpoint.sequence();
+    
+    PROFILE_STOP( loopProfile, PHASE_PUBLISH );
+
+    //========================================================================================================
+    // update the front panel LED's
+    //
+    //========================================================================================================
+    PROFILE_START( loopProfile, PHASE_LED );
+    update_leds( );
+    PROFILE_STOP( loopProfile, PHASE_LED );
+    
+    PROFILE_STOP( loopProfile, PHASE_LOOP );
+    
+    loopUs = (int)(micros() - scanStart);
+    if (loopUs > loopMaxUs) {
+        loopMaxUs = loopUs;
+    }
+    
+#ifdef USE_LOOP_PROFILE
+    if (profileRenderSchedule.due( millis() )) {
+        render_loop_profile( );
+    }
+#endif
+    
+#ifdef USE_HEAP_STATS
+    CxHeapStats::endIteration( steadyState );
+#endif
+    
+    //========================================================================================================
+    // delay a quarter second
+    //
+    //========================================================================================================
+
+    delay(250);
+}
@@ -0,0 +1,349 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxarming.cpp
+//
+//  CxArming Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxarming.h>
+
+#define WATCH_PERIMETER  0x01
+#define WATCH_INTERIOR   0x02
+
+// zone classes each mode watches, indexed by mode
+
+static const uint8_t modeWatches[ ARM_MODES ] = {
+    0,                                      // ARM_DISARMED
+    WATCH_PERIMETER,                        // ARM_STAY
+    WATCH_PERIMETER | WATCH_INTERIOR        // ARM_AWAY
+};
+
+static const char *modeNames[ ARM_MODES ] = { "DISARMED", "STAY", "AWAY" };
+
+struct CxArmingRecord
+{
+    uint32_t magic;
+    uint32_t mode;
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::CxArming
+//
+//------------------------------------------------------------------------------------------------------------
+CxArming::CxArming( void )
+: _interiorBits( 0 ),
+  _entryZoneBits( 0 ),
+  _exitZoneBits( 0 ),
+  _bypassBits( 0 ),
+  _scheduledBits( 0 ),
+  _exitPendingBits( 0 ),
+  _alarmBits( 0 ),
+  _entryBits( 0 ),
+  _entryTrippedBits( 0 ),
+  _latchedBits( 0 ),
+  _armedMillis( 0 ),
+  _nextExitMillis( 0 ),
+  _entryDeadline( 0 ),
+  _entryRunning( FALSE ),
+  _entryExpired( FALSE ),
+  _mode( ARM_AWAY )
+{
+    for (int m=0; m<ARM_MODES; m++) {
+        _armedBits[ m ] = 0;
+    }
+
+    memset( _entryDelay, 0, sizeof( _entryDelay ));
+    memset( _exitDelay, 0, sizeof( _exitDelay ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::configure
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxArming::configure( uint64_t perimeterBits, uint64_t interiorBits )
+{
+    _interiorBits = interiorBits;
+
+    for (int m=0; m<ARM_MODES; m++) {
+        _armedBits[ m ] = ((modeWatches[ m ] & WATCH_PERIMETER) ? perimeterBits : 0) |
+                          ((modeWatches[ m ] & WATCH_INTERIOR)  ? interiorBits  : 0);
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::setDelays
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxArming::setDelays( int channel, int entrySeconds, int exitSeconds )
+{
+    if (channel < 0 || channel >= ARMING_CHANNELS) return;
+
+    uint64_t bit = 1ULL << channel;
+
+    _entryDelay[ channel ] = (entrySeconds > 0) ? entrySeconds : 0;
+    _exitDelay[ channel ]  = (exitSeconds  > 0) ? exitSeconds  : 0;
+
+    if (_entryDelay[ channel ]) _entryZoneBits |= bit; else _entryZoneBits &= ~bit;
+    if (_exitDelay[ channel ])  _exitZoneBits  |= bit; else _exitZoneBits  &= ~bit;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::restore
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxArming::restore( int defaultMode )
+{
+    CxArmingRecord record;
+
+    EEPROM.get( ARMING_EEPROM_ADDRESS, record );
+
+    if (record.magic == ARMING_MAGIC && record.mode < ARM_MODES) {
+        _mode = record.mode;
+    } else {
+        _mode = defaultMode;
+    }
+
+    return( _mode );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::setMode
+//
+// Any mode change abandons a running entry countdown, only disarming clears latched entry zones.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxArming::setMode( int mode, unsigned long nowMillis )
+{
+    if (mode < 0 || mode >= ARM_MODES) return( FALSE );
+
+    _mode             = mode;
+    _entryRunning     = FALSE;
+    _entryExpired     = FALSE;
+    _entryTrippedBits = 0;
+    _armedMillis      = nowMillis;
+
+    if (mode == ARM_DISARMED) _latchedBits = 0;
+
+    _exitPendingBits = _exitZoneBits & _armedBits[ mode ];
+    _nextExitMillis  = nowMillis;
+    expireExitDelays( nowMillis );
+
+    CxArmingRecord record;
+    record.magic = ARMING_MAGIC;
+    record.mode  = mode;
+    EEPROM.put( ARMING_EEPROM_ADDRESS, record );
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::mode
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxArming::mode( void ) const
+{
+    return( _mode );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::setBypass
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxArming::setBypass( int channel, int bypass )
+{
+    if (channel < 0 || channel >= ARMING_CHANNELS) return;
+
+    if (bypass) {
+        _bypassBits |= (1ULL << channel);
+    } else {
+        _bypassBits &= ~(1ULL << channel);
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::setScheduledBypass
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxArming::setScheduledBypass( uint64_t bits )
+{
+    _scheduledBits = bits;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::bypassBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxArming::bypassBits( void ) const
+{
+    return( _bypassBits | _scheduledBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::evaluate
+//
+// The first delayed zone to open starts a single countdown using the shortest delay among the
+// zones open at that moment, like a panel's entry timer.  While it runs the open entry and interior
+// zones wait, anything else alarms at once.  When it runs out the entry zones that opened during it
+// are latched, so shutting the door behind you doesn't silence the alarm, and the entry zones
+// become instant until the mode is changed.
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxArming::evaluate( uint64_t openBits, unsigned long nowMillis )
+{
+    if (_exitPendingBits && (long)(nowMillis - _nextExitMillis) >= 0) {
+        expireExitDelays( nowMillis );
+    }
+
+    uint64_t tripped = openBits & _armedBits[ _mode ] & ~(_bypassBits | _scheduledBits) & ~_exitPendingBits;
+    uint64_t delayed = tripped & _entryZoneBits;
+
+    if (delayed && !_entryRunning && !_entryExpired) {
+
+        unsigned long shortest = 0xFFFF;
+
+        while (delayed) {
+            int channel = __builtin_ctzll( delayed );
+            delayed &= delayed - 1;
+            if (_entryDelay[ channel ] < shortest) shortest = _entryDelay[ channel ];
+        }
+
+        _entryDeadline = nowMillis + shortest * 1000UL;
+        _entryRunning  = TRUE;
+    }
+
+    if (_entryRunning) {
+        _entryTrippedBits |= tripped & _entryZoneBits;
+    }
+
+    if (_entryRunning && (long)(nowMillis - _entryDeadline) >= 0) {
+        _entryRunning      = FALSE;
+        _entryExpired      = TRUE;
+        _latchedBits      |= _entryTrippedBits;
+        _entryTrippedBits  = 0;
+    }
+
+    _entryBits = _entryRunning ? tripped & (_entryZoneBits | _interiorBits) & ~_latchedBits : 0;
+    _alarmBits = (tripped & ~_entryBits) | _latchedBits;
+
+    return( _alarmBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::alarmBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxArming::alarmBits( void ) const
+{
+    return( _alarmBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::entryBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxArming::entryBits( void ) const
+{
+    return( _entryBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::latchedBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxArming::latchedBits( void ) const
+{
+    return( _latchedBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::modeName
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+const char *
+CxArming::modeName( int mode )
+{
+    if (mode < 0 || mode >= ARM_MODES) return( "UNKNOWN" );
+    return( modeNames[ mode ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxArming::expireExitDelays
+//
+// Only runs when the earliest pending exit delay is due, and only looks at zones still pending.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxArming::expireExitDelays( unsigned long nowMillis )
+{
+    uint64_t      pending  = _exitPendingBits;
+    unsigned long elapsed  = nowMillis - _armedMillis;
+    unsigned long earliest = 0xFFFFFFFF;
+
+    while (pending) {
+
+        int channel = __builtin_ctzll( pending );
+        pending &= pending - 1;
+
+        unsigned long delay = _exitDelay[ channel ] * 1000UL;
+
+        if (elapsed >= delay) {
+            _exitPendingBits &= ~(1ULL << channel);
+        } else if (delay < earliest) {
+            earliest = delay;
+        }
+    }
+
+    _nextExitMillis = _armedMillis + earliest;
+}
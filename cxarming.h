@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxarming.h
+//
+//  CxArming Class
+//
+//  Decides which open zones are an alarm.  The system is in one of three modes: DISARMED watches
+//  nothing, STAY watches the perimeter (doors and windows) and AWAY watches the perimeter and the
+//  interior (motion).  Which zone classes each mode watches comes from a small table, configure()
+//  turns it into one bitmask per mode so evaluate() is a handful of 64 bit operations however many
+//  zones there are.
+//
+//  Zones can be bypassed, and can have an entry delay (opening the zone starts a countdown to
+//  disarm before it alarms, interior zones follow the countdown too) and an exit delay (the zone is
+//  ignored for a while after arming so you can leave).  A countdown that runs out latches the entry
+//  zones that opened during it as alarming, shut again or not, until the system is disarmed.  The
+//  mode is kept in EEPROM so a reset comes back in the same mode, without restarting the exit delay.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxArming_h_
+#define _CxArming_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define ARM_DISARMED           0
+#define ARM_STAY               1
+#define ARM_AWAY               2
+#define ARM_MODES              3
+
+#define ARMING_CHANNELS        48
+#define ARMING_EEPROM_ADDRESS  16           // after the sequence reservation
+#define ARMING_MAGIC           0x41524D31   // "ARM1"
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxArming
+//
+//------------------------------------------------------------------------------------------------------------
+class CxArming
+{
+  public:
+
+    CxArming( void );
+    // constructor
+
+    void configure( uint64_t perimeterBits, uint64_t interiorBits );
+    // classify the zones and build the per mode masks
+
+    void setDelays( int channel, int entrySeconds, int exitSeconds );
+    // entry and exit delay for one zone, zero for none
+
+    int restore( int defaultMode );
+    // pick the mode back up from EEPROM, defaultMode if it was never saved.  Returns the mode
+
+    int setMode( int mode, unsigned long nowMillis );
+    // change mode and save it, arming starts the exit delays.  Returns FALSE for a bad mode
+
+    int mode( void ) const;
+
+    void setBypass( int channel, int bypass );
+    // a bypassed zone never alarms in any mode
+
+    void setScheduledBypass( uint64_t bits );
+    // zones bypassed by the schedule, kept apart from the ones bypassed by hand
+
+    uint64_t bypassBits( void ) const;
+    // every zone bypassed right now, by hand or by schedule
+
+    uint64_t evaluate( uint64_t openBits, unsigned long nowMillis );
+    // work out the zones that are alarming now, called every scan
+
+    uint64_t alarmBits( void ) const;
+    // result of the last evaluate(), latched entry zones included even if they have shut since
+
+    uint64_t entryBits( void ) const;
+    // open zones waiting on the entry countdown as of the last evaluate()
+
+    uint64_t latchedBits( void ) const;
+    // entry zones latched by a countdown that ran out, alarming until disarmed
+
+    static const char *modeName( int mode );
+    // DISARMED, STAY, AWAY
+
+  private:
+
+    void expireExitDelays( unsigned long nowMillis );
+    // drop zones whose exit delay has run out and find the next one due
+
+    uint64_t      _armedBits[ ARM_MODES ];  // zones each mode watches
+    uint64_t      _interiorBits;
+    uint64_t      _entryZoneBits;           // zones with an entry delay
+    uint64_t      _exitZoneBits;            // zones with an exit delay
+    uint64_t      _bypassBits;
+    uint64_t      _scheduledBits;
+    uint64_t      _exitPendingBits;         // zones still inside their exit delay
+    uint64_t      _alarmBits;
+    uint64_t      _entryBits;
+    uint64_t      _entryTrippedBits;        // entry zones opened while the countdown ran
+    uint64_t      _latchedBits;             // entry zones alarming until disarmed
+    uint16_t      _entryDelay[ ARMING_CHANNELS ];   // seconds
+    uint16_t      _exitDelay[ ARMING_CHANNELS ];    // seconds
+    unsigned long _armedMillis;
+    unsigned long _nextExitMillis;
+    unsigned long _entryDeadline;
+    int           _entryRunning;
+    int           _entryExpired;            // the countdown ran out, entry zones alarm straight away
+    int           _mode;
+};
+
+
+#endif
@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxchaintest.cpp
+//
+//  CxChainTest Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxchaintest.h>
+
+static const char *faultNames[ CHAIN_FAULTS ] = { "NONE", "UNSTABLE", "STUCK" };
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::CxChainTest
+//
+//------------------------------------------------------------------------------------------------------------
+CxChainTest::CxChainTest( void )
+: _fault( CHAIN_OK ),
+  _inputDelay( SN74HC165N_DEFAULT_DELAY_US ),
+  _testMicros( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::run
+//
+// Shorter delays are tried from the stock one down and the search stops at the first that fails,
+// then the delay chosen is checked once more against a fresh reference so a zone changing during
+// the search can't leave the chain on a delay that only looked good.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxChainTest::run( SN74HC165N *inputs, int bits )
+{
+    unsigned long start = micros();
+    int total = bits + CHAIN_TEST_EXTRA_BITS;
+
+    if (total > 64) total = 64;
+
+    uint64_t chainMask = (bits  >= 64) ? ~0ULL : ((1ULL << bits) - 1);
+    uint64_t totalMask = (total >= 64) ? ~0ULL : ((1ULL << total) - 1);
+    uint64_t extraMask = totalMask & ~chainMask;
+    uint64_t extraTied = CHAIN_SERIAL_LEVEL ? extraMask : 0;
+
+    _fault      = CHAIN_OK;
+    _inputDelay = SN74HC165N_DEFAULT_DELAY_US;
+
+    inputs->setPulseDelay( _inputDelay );
+    uint64_t reference = inputs->readChain( total );
+
+    if (!passes( inputs, SN74HC165N_DEFAULT_DELAY_US, total, &reference )) {
+        _fault = CHAIN_UNSTABLE;
+    } else if ((reference & extraMask) != extraTied) {
+        _fault = CHAIN_STUCK;
+    } else {
+
+        int shortest = SN74HC165N_DEFAULT_DELAY_US;
+
+        for (int delay=SN74HC165N_DEFAULT_DELAY_US-1; delay>=0; delay--) {
+            if (!passes( inputs, delay, total, &reference )) break;
+            shortest = delay;
+        }
+
+        _inputDelay = shortest + CHAIN_TEST_MARGIN_US;
+        if (_inputDelay > SN74HC165N_DEFAULT_DELAY_US) _inputDelay = SN74HC165N_DEFAULT_DELAY_US;
+
+        if (!passes( inputs, _inputDelay, total, &reference )) {
+            _inputDelay = SN74HC165N_DEFAULT_DELAY_US;
+        }
+    }
+
+    inputs->setPulseDelay( _inputDelay );
+
+    _testMicros = micros() - start;
+
+    return( _fault );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::fault
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxChainTest::fault( void ) const
+{
+    return( _fault );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::inputDelay
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxChainTest::inputDelay( void ) const
+{
+    return( _inputDelay );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::testMicros
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxChainTest::testMicros( void ) const
+{
+    return( _testMicros );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::faultName
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+const char *
+CxChainTest::faultName( int fault )
+{
+    if (fault < 0 || fault >= CHAIN_FAULTS) return( "UNKNOWN" );
+    return( faultNames[ fault ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::format
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxChainTest::format( char *buffer, int size ) const
+{
+    return( snprintf( buffer, size, "{\"fault\":\"%s\",\"scan_delay_us\":%d,\"test_us\":%lu}",
+                      faultName( _fault ), _inputDelay, _testMicros ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::passes
+//
+// The first try uses the reference the caller already has.  Each retry takes a new reference at the
+// stock delay, if the chain at delay agrees with it the earlier mismatch was a zone moving, not the
+// timing.
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxChainTest::passes( SN74HC165N *inputs, int delay, int bits, uint64_t *reference )
+{
+    for (int attempt=0; attempt<=CHAIN_TEST_RETRIES; attempt++) {
+
+        if (attempt > 0) {
+            inputs->setPulseDelay( SN74HC165N_DEFAULT_DELAY_US );
+            *reference = inputs->readChain( bits );
+        }
+
+        inputs->setPulseDelay( delay );
+        if (stable( inputs, bits, *reference )) return( TRUE );
+    }
+
+    return( FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxChainTest::stable
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxChainTest::stable( SN74HC165N *inputs, int bits, uint64_t reference )
+{
+    for (int r=0; r<CHAIN_TEST_READS; r++) {
+        if (inputs->readChain( bits ) != reference) return( FALSE );
+    }
+
+    return( TRUE );
+}
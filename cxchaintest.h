@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxchaintest.h
+//
+//  CxChainTest Class
+//
+//  Self test and timing calibration for the zone input chain.  The chain is read repeatedly at the
+//  stock 5us pulse to get a reference, then at shorter pulses.  The shortest pulse that still gives
+//  the reference every time, plus a microsecond of margin, becomes the chain's delay.
+//
+//  Shifting past the end of the chain reads the first register's serial input, which is tied to
+//  CHAIN_SERIAL_LEVEL.  Those extra bits don't depend on any zone, so they are what tells a stuck
+//  or broken data line apart from a house that happens to have every zone closed.  A data line
+//  stuck at the tied level itself can't be seen this way.
+//
+//  The level is high: SER on SR6, the register on board 2 of AlarmSystemSchematic.pdf farthest from
+//  the Photon, goes to +5V like the zone pull-ups on board 3.  A closed zone reads low, so a data
+//  line stuck low, which would pass for a quiet house, reads low past the end too and is caught.  A
+//  line stuck high can't be told from every zone open, but that trips the relay by itself.
+//
+//  Zones can change while the test runs.  A read that disagrees with the reference is only held
+//  against the chain once a fresh reference, read at the stock delay, still disagrees with it.
+//
+//  The LED chain has no path back to the processor on this board, so nothing here can check it and
+//  it stays on its stock timing.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <SN74HC165N.h>
+
+#ifndef _CxChainTest_h_
+#define _CxChainTest_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define CHAIN_SERIAL_LEVEL      1       // level the first register's serial input is tied to
+#define CHAIN_TEST_READS        8       // reads that must agree at each delay
+#define CHAIN_TEST_RETRIES      3       // fresh references taken before a disagreement is a fault
+#define CHAIN_TEST_EXTRA_BITS   8       // bits read past the end of the chain
+#define CHAIN_TEST_MARGIN_US    1       // added to the shortest delay that passed
+
+#define CHAIN_OK                0
+#define CHAIN_UNSTABLE          1       // reads keep disagreeing at the stock delay
+#define CHAIN_STUCK             2       // the bits past the end don't read the tied level
+#define CHAIN_FAULTS            3
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxChainTest
+//
+//------------------------------------------------------------------------------------------------------------
+class CxChainTest
+{
+  public:
+
+    CxChainTest( void );
+    // constructor
+
+    int run( SN74HC165N *inputs, int bits );
+    // test and calibrate a chain of bits inputs and set its delay.  Returns CHAIN_OK or the fault
+    // found, any fault leaves the chain on the stock delay
+
+    int fault( void ) const;
+    // fault found by the last run
+
+    int inputDelay( void ) const;
+    // calibrated input pulse, microseconds
+
+    unsigned long testMicros( void ) const;
+    // how long the last run took
+
+    static const char *faultName( int fault );
+    // NONE, UNSTABLE, STUCK
+
+    int format( char *buffer, int size ) const;
+    // {"fault":"NONE","scan_delay_us":<n>,"test_us":<n>}
+
+  private:
+
+    static int passes( SN74HC165N *inputs, int delay, int bits, uint64_t *reference );
+    // TRUE if CHAIN_TEST_READS reads at delay all match the reference.  A mismatch is checked
+    // against a fresh reference read at the stock delay, up to CHAIN_TEST_RETRIES times
+
+    static int stable( SN74HC165N *inputs, int bits, uint64_t reference );
+    // TRUE if CHAIN_TEST_READS reads all come back as reference
+
+    int           _fault;
+    int           _inputDelay;
+    unsigned long _testMicros;
+};
+
+
+#endif
@@ -0,0 +1,422 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxcheckpoint.cpp
+//
+//  CxCheckpoint Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxcheckpoint.h>
+
+// the image itself lives in backup SRAM and survives any reset that doesn't remove power
+
+retained CxCheckpointImage checkpointImage;
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::CxCheckpoint
+//
+//------------------------------------------------------------------------------------------------------------
+CxCheckpoint::CxCheckpoint( void )
+: _warm( FALSE ),
+  _restoreMicros( 0 ),
+  _reservedLimit( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::restore
+//
+// The image is only trusted if it was written by this layout for the same set of configured zones
+// and the crc matches, anything else is a cold start.  A cold start picks the sequence numbers up
+// from the end of the block last reserved in EEPROM.  On a warm start nothing in the backlog is with
+// the publisher any more.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxCheckpoint::restore( int channels, uint64_t configuredBits )
+{
+    unsigned long start = micros();
+
+    CxCheckpointImage *image = &checkpointImage;
+
+    _warm = (image->magic          == CHECKPOINT_MAGIC) &&
+            (image->version        == CHECKPOINT_VERSION) &&
+            (image->channels       == channels) &&
+            (image->configuredBits == configuredBits) &&
+            (image->backlogCount   <= CHECKPOINT_BACKLOG) &&
+            (image->backlogHead    <  CHECKPOINT_BACKLOG) &&
+            (image->crc == crc32( (const uint8_t *) image, offsetof( CxCheckpointImage, crc )));
+
+    loadReservation();
+
+    if (!_warm) {
+        initialize( channels, configuredBits );
+
+        image->sequence = _reservedLimit;
+        seal();
+    } else {
+        for (int i=0; i<CHECKPOINT_BACKLOG; i++) {
+            image->backlog[i].flags = 0;
+        }
+        seal();
+    }
+
+    _restoreMicros = micros() - start;
+
+    return( _warm );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::warm
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxCheckpoint::warm( void ) const
+{
+    return( _warm );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::restoreMicros
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxCheckpoint::restoreMicros( void ) const
+{
+    return( _restoreMicros );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::activatedBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxCheckpoint::activatedBits( void ) const
+{
+    return( checkpointImage.activatedBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::sequence
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxCheckpoint::sequence( void ) const
+{
+    return( checkpointImage.sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::nextSequence
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxCheckpoint::nextSequence( void )
+{
+    unsigned long sequence = advanceSequence();
+    seal();
+
+    return( sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::recordTransition
+//
+// When the backlog is full the oldest unconfirmed transition is given up, the newest state of
+// the zones is always in activatedBits regardless.
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxCheckpoint::recordTransition( int channel, int activated, int severity, unsigned long time, uint64_t activatedBits )
+{
+    CxCheckpointImage *image = &checkpointImage;
+
+    advanceSequence();
+    image->activatedBits = activatedBits;
+
+    if (image->backlogCount == CHECKPOINT_BACKLOG) {
+        image->backlogHead = (image->backlogHead + 1) % CHECKPOINT_BACKLOG;
+        image->backlogCount--;
+    }
+
+    CxCheckpointEvent *event = &image->backlog[ (image->backlogHead + image->backlogCount) % CHECKPOINT_BACKLOG ];
+    event->sequence  = image->sequence;
+    event->time      = time;
+    event->channel   = channel;
+    event->activated = activated ? 1 : 0;
+    event->flags     = 0;
+    event->severity  = severity;
+
+    image->backlogCount++;
+
+    seal();
+
+    return( image->sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::reconfigure
+//
+// The backlog is kept, a transition for a zone that just left the system still has to go out.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::reconfigure( uint64_t configuredBits, uint64_t activatedBits )
+{
+    checkpointImage.configuredBits = configuredBits;
+    checkpointImage.activatedBits  = activatedBits;
+
+    seal();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::queued
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::queued( unsigned long firstSequence, unsigned long sequence )
+{
+    if (mark( firstSequence, sequence, TRUE )) seal();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::completed
+//
+// Events don't finish in sequence order, an earlier one may still be retrying or may have been
+// dropped, so only entries inside the run are removed and the rest keep their order.  Nothing is
+// written unless the backlog actually shrinks.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::completed( unsigned long firstSequence, unsigned long sequence )
+{
+    CxCheckpointImage *image = &checkpointImage;
+
+    int kept = 0;
+
+    for (int i=0; i<image->backlogCount; i++) {
+
+        CxCheckpointEvent *event = &image->backlog[ (image->backlogHead + i) % CHECKPOINT_BACKLOG ];
+
+        if ((int32_t)(event->sequence - firstSequence) >= 0 &&
+            (int32_t)(event->sequence - sequence) <= 0) {
+            continue;
+        }
+
+        if (kept != i) {
+            image->backlog[ (image->backlogHead + kept) % CHECKPOINT_BACKLOG ] = *event;
+        }
+        kept++;
+    }
+
+    if (kept == image->backlogCount) return;
+
+    image->backlogCount = kept;
+
+    seal();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::abandoned
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::abandoned( unsigned long firstSequence, unsigned long sequence )
+{
+    if (mark( firstSequence, sequence, FALSE )) seal();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::backlogEntries
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxCheckpoint::backlogEntries( void ) const
+{
+    return( checkpointImage.backlogCount );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::backlogAt
+//
+//------------------------------------------------------------------------------------------------------------
+const CxCheckpointEvent *
+CxCheckpoint::backlogAt( int i ) const
+{
+    if (i < 0 || i >= checkpointImage.backlogCount) return( NULL );
+    return( &checkpointImage.backlog[ (checkpointImage.backlogHead + i) % CHECKPOINT_BACKLOG ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::advanceSequence
+//
+// The EEPROM write only happens once every SEQUENCE_BLOCK numbers, which keeps flash wear and the
+// occasional slow emulated EEPROM write off nearly every scan.  The caller seals the image.
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxCheckpoint::advanceSequence( void )
+{
+    CxCheckpointImage *image = &checkpointImage;
+
+    image->sequence++;
+
+    if ((int32_t)(image->sequence - _reservedLimit) > 0) {
+
+        CxSequenceReservation reservation;
+        reservation.magic = SEQUENCE_MAGIC;
+        reservation.limit = image->sequence + SEQUENCE_BLOCK - 1;
+        reservation.check = ~reservation.limit;
+
+        EEPROM.put( SEQUENCE_EEPROM_ADDRESS, reservation );
+        _reservedLimit = reservation.limit;
+    }
+
+    return( image->sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::loadReservation
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::loadReservation( void )
+{
+    CxSequenceReservation reservation;
+
+    EEPROM.get( SEQUENCE_EEPROM_ADDRESS, reservation );
+
+    if (reservation.magic == SEQUENCE_MAGIC && reservation.check == ~reservation.limit) {
+        _reservedLimit = reservation.limit;
+    } else {
+        _reservedLimit = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::mark
+//
+// The caller seals the image.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxCheckpoint::mark( unsigned long firstSequence, unsigned long sequence, int queued )
+{
+    CxCheckpointImage *image = &checkpointImage;
+
+    int changed = 0;
+
+    for (int i=0; i<image->backlogCount; i++) {
+
+        CxCheckpointEvent *event = &image->backlog[ (image->backlogHead + i) % CHECKPOINT_BACKLOG ];
+
+        if ((int32_t)(event->sequence - firstSequence) < 0 ||
+            (int32_t)(event->sequence - sequence) > 0) {
+            continue;
+        }
+
+        uint8_t flags = queued ? (event->flags | CHECKPOINT_QUEUED) : (event->flags & ~CHECKPOINT_QUEUED);
+
+        if (flags != event->flags) {
+            event->flags = flags;
+            changed++;
+        }
+    }
+
+    return( changed );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::initialize
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::initialize( int channels, uint64_t configuredBits )
+{
+    CxCheckpointImage *image = &checkpointImage;
+
+    memset( image, 0, sizeof( CxCheckpointImage ));
+
+    image->magic          = CHECKPOINT_MAGIC;
+    image->version        = CHECKPOINT_VERSION;
+    image->channels       = channels;
+    image->configuredBits = configuredBits;
+
+    seal();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::seal
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxCheckpoint::seal( void )
+{
+    checkpointImage.crc = crc32( (const uint8_t *) &checkpointImage, offsetof( CxCheckpointImage, crc ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpoint::crc32
+//
+// Bitwise CRC32 (reflected, 0xEDB88320), the image is a couple of hundred bytes so a table isn't
+// worth the flash.
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+uint32_t
+CxCheckpoint::crc32( const uint8_t *data, int len )
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (int i=0; i<len; i++) {
+        crc ^= data[i];
+        for (int b=0; b<8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+
+    return( ~crc );
+}
@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxcheckpoint.h
+//
+//  CxCheckpoint Class
+//
+//  Keeps a checkpoint of the zone state in retained (backup) SRAM so a reset that doesn't lose power,
+//  a watchdog or firmware fault for example, can pick up where it left off.  The checkpoint holds the
+//  packed activated bits, the event sequence number and a small backlog of zone transitions that
+//  haven't been confirmed by the publisher yet.  It is updated only when a zone changes or the
+//  publisher reports on an event, and sealed with a CRC so a torn or stale image is never trusted.
+//
+//  Each backlog entry is confirmed on its own.  An entry leaves the backlog only when the event
+//  carrying its exact sequence was published, an entry whose event was dropped or abandoned stays
+//  and is handed out again by the application.
+//
+//  The application must enable retained memory with
+//  STARTUP(System.enableFeature(FEATURE_RETAINED_MEMORY));
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxCheckpoint_h_
+#define _CxCheckpoint_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define CHECKPOINT_MAGIC     0x414C524D     // "ALRM"
+#define CHECKPOINT_VERSION   3
+#define CHECKPOINT_BACKLOG   16             // unconfirmed transitions kept across a reset
+
+#define CHECKPOINT_QUEUED    0x01           // entry flag, an event for it is with the publisher
+
+#define SEQUENCE_EEPROM_ADDRESS  0          // where the sequence reservation lives in EEPROM
+#define SEQUENCE_MAGIC           0x53455131 // "SEQ1"
+#define SEQUENCE_BLOCK           64         // sequence numbers reserved by each EEPROM write
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpointEvent
+//
+// One zone transition waiting for the publisher, 12 bytes.
+//
+//------------------------------------------------------------------------------------------------------------
+struct CxCheckpointEvent
+{
+    uint32_t sequence;
+    uint32_t time;                          // seconds from epoch
+    uint8_t  channel;                       // channel index, zero based
+    uint8_t  activated;
+    uint8_t  flags;                         // CHECKPOINT_QUEUED
+    uint8_t  severity;                      // the application's message type, resent as it was
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxCheckpointImage
+//
+// The layout stored in retained memory.  Changing it requires bumping CHECKPOINT_VERSION.
+//
+//------------------------------------------------------------------------------------------------------------
+struct CxCheckpointImage
+{
+    uint32_t          magic;
+    uint16_t          version;
+    uint16_t          channels;
+    uint32_t          sequence;             // last sequence number handed out
+    uint64_t          configuredBits;
+    uint64_t          activatedBits;        // as last reported to the cloud
+    uint16_t          backlogHead;          // oldest entry
+    uint16_t          backlogCount;
+    CxCheckpointEvent backlog[ CHECKPOINT_BACKLOG ];
+    uint32_t          crc;                  // CRC32 of everything above
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSequenceReservation
+//
+// Kept in EEPROM so sequence numbers keep climbing after a reset that lost retained memory.  Rather
+// than writing every number the checkpoint reserves a block at a time, a cold start resumes past the
+// end of the last block so a number is never handed out twice, at the cost of a gap.
+//
+//------------------------------------------------------------------------------------------------------------
+struct CxSequenceReservation
+{
+    uint32_t magic;
+    uint32_t limit;                         // highest sequence number that may have been used
+    uint32_t check;                         // ~limit
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxCheckpoint
+//
+//------------------------------------------------------------------------------------------------------------
+class CxCheckpoint
+{
+  public:
+
+    CxCheckpoint( void );
+    // constructor
+
+    int restore( int channels, uint64_t configuredBits );
+    // validate the retained image, returns TRUE (warm start) if it can be used.  Otherwise the
+    // image is re-initialized and FALSE (cold start) is returned
+
+    int warm( void ) const;
+    // TRUE if the last restore() found a good image
+
+    unsigned long restoreMicros( void ) const;
+    // how long restore() took
+
+    uint64_t activatedBits( void ) const;
+    // the activated bits as of the last checkpoint, what the cloud was last told
+
+    unsigned long sequence( void ) const;
+    // the last sequence number handed out
+
+    unsigned long nextSequence( void );
+    // hand out the next sequence number for an event that isn't a zone transition
+
+    unsigned long recordTransition( int channel, int activated, int severity, unsigned long time, uint64_t activatedBits );
+    // hand out the next sequence number for a zone transition and add it to the backlog
+
+    void reconfigure( uint64_t configuredBits, uint64_t activatedBits );
+    // the set of configured zones changed at run time, so the image still restores after a reset
+
+    void queued( unsigned long firstSequence, unsigned long sequence );
+    // an event carrying the transitions from firstSequence to sequence went to the publisher
+
+    void completed( unsigned long firstSequence, unsigned long sequence );
+    // the event carrying those transitions was published, they leave the backlog
+
+    void abandoned( unsigned long firstSequence, unsigned long sequence );
+    // the event carrying those transitions was given up, they are unqueued so they go out again
+
+    int backlogEntries( void ) const;
+    // transitions not yet confirmed by the publisher
+
+    const CxCheckpointEvent *backlogAt( int i ) const;
+    // the i'th oldest unconfirmed transition
+
+    static uint32_t crc32( const uint8_t *data, int len );
+    // CRC32 (reflected, 0xEDB88320) of len bytes
+
+  private:
+
+    unsigned long advanceSequence( void );
+    // bump the sequence number, reserving another block in EEPROM when the current one runs out
+
+    void loadReservation( void );
+    // read the reserved limit from EEPROM, zero if it was never written
+
+    int mark( unsigned long firstSequence, unsigned long sequence, int queued );
+    // set or clear CHECKPOINT_QUEUED on the entries in the run, returns the number changed
+
+    void initialize( int channels, uint64_t configuredBits );
+    // start a fresh image
+
+    void seal( void );
+    // recompute the crc after a change
+
+    int           _warm;
+    unsigned long _restoreMicros;
+    unsigned long _reservedLimit;
+};
+
+
+#endif
@@ -0,0 +1,310 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxconfigblob.cpp
+//
+//  CxConfigBlob Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxcheckpoint.h>
+#include <cxconfigblob.h>
+
+static const char _base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::CxConfigBlob
+//
+//------------------------------------------------------------------------------------------------------------
+CxConfigBlob::CxConfigBlob( void )
+: _length( 0 ), _position( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::decode
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::decode( const char *text )
+{
+    _length = decodeBase64( text, _data, sizeof( _data ));
+
+    if (_length < 0) {
+        _length = 0;
+        return( CONFIG_BAD_ENCODING );
+    }
+
+    int result = validate();
+    if (result != CONFIG_OK) _length = 0;
+
+    return( result );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::load
+//
+// The header is read first so only as much EEPROM as the blob really uses is copied.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::load( void )
+{
+    for (int i=0; i<CONFIG_HEADER_BYTES; i++) {
+        _data[i] = EEPROM.read( CONFIG_EEPROM_ADDRESS + i );
+    }
+
+    _length = CONFIG_HEADER_BYTES;
+    if (get16( 0 ) != CONFIG_MAGIC) {
+        _length = 0;
+        return( CONFIG_BAD_MAGIC );
+    }
+
+    int length = CONFIG_HEADER_BYTES + get16( 4 );
+    if (length > CONFIG_MAX_BYTES) {
+        _length = 0;
+        return( CONFIG_BAD_SIZE );
+    }
+
+    for (int i=CONFIG_HEADER_BYTES; i<length; i++) {
+        _data[i] = EEPROM.read( CONFIG_EEPROM_ADDRESS + i );
+    }
+    _length = length;
+
+    int result = validate();
+    if (result != CONFIG_OK) _length = 0;
+
+    return( result );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::save
+//
+// Only the bytes that differ are written, so saving the blob already in EEPROM costs no flash wear.
+// An empty blob just wipes the magic.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxConfigBlob::save( void ) const
+{
+    if (_length == 0) {
+        EEPROM.write( CONFIG_EEPROM_ADDRESS, 0 );
+        EEPROM.write( CONFIG_EEPROM_ADDRESS + 1, 0 );
+        return;
+    }
+
+    for (int i=0; i<_length; i++) {
+        if (EEPROM.read( CONFIG_EEPROM_ADDRESS + i ) != _data[i]) {
+            EEPROM.write( CONFIG_EEPROM_ADDRESS + i, _data[i] );
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::clear
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxConfigBlob::clear( void )
+{
+    _length   = 0;
+    _position = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::validate
+//
+// Every record is checked before any is used, a blob is applied whole or not at all.  A channel may
+// only appear once and descriptions must be printable and free of quotes and backslashes, they go
+// straight into event json.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::validate( void ) const
+{
+    if (_length == 0) return( CONFIG_OK );
+
+    if (_length < CONFIG_HEADER_BYTES) return( CONFIG_BAD_SIZE );
+    if (get16( 0 ) != CONFIG_MAGIC)    return( CONFIG_BAD_MAGIC );
+    if (_data[2] != CONFIG_VERSION)    return( CONFIG_BAD_VERSION );
+
+    if (CONFIG_HEADER_BYTES + get16( 4 ) != _length) return( CONFIG_BAD_SIZE );
+
+    if (CxCheckpoint::crc32( &_data[ CONFIG_HEADER_BYTES ], _length - CONFIG_HEADER_BYTES ) != get32( 6 )) {
+        return( CONFIG_BAD_CRC );
+    }
+
+    uint64_t seen  = 0;
+    int      pos   = CONFIG_HEADER_BYTES;
+    int      count = 0;
+
+    while (pos < _length) {
+
+        if (pos + 3 > _length) return( CONFIG_BAD_RECORD );
+
+        int channel = _data[ pos ];
+        int flags   = _data[ pos + 1 ];
+        int nameLen = _data[ pos + 2 ];
+
+        if (channel >= CONFIG_CHANNELS)        return( CONFIG_BAD_RECORD );
+        if (seen & (1ULL << channel))          return( CONFIG_BAD_RECORD );
+        if (flags & ~CONFIG_ACTIVE)            return( CONFIG_BAD_RECORD );
+        if (nameLen > CONFIG_NAME_MAX)         return( CONFIG_BAD_RECORD );
+        if (pos + 3 + nameLen > _length)       return( CONFIG_BAD_RECORD );
+
+        for (int i=0; i<nameLen; i++) {
+            char ch = _data[ pos + 3 + i ];
+            if (ch < ' ' || ch > '~' || ch == '"' || ch == '\\') return( CONFIG_BAD_RECORD );
+        }
+
+        seen |= (1ULL << channel);
+        pos  += 3 + nameLen;
+        count++;
+    }
+
+    if (count != _data[3]) return( CONFIG_BAD_RECORD );
+
+    return( CONFIG_OK );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::records
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::records( void ) const
+{
+    if (_length == 0) return( 0 );
+    return( _data[3] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::first
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::first( CxConfigRecord *record )
+{
+    _position = CONFIG_HEADER_BYTES;
+    return( next( record ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::next
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxConfigBlob::next( CxConfigRecord *record )
+{
+    if (_position < CONFIG_HEADER_BYTES || _position >= _length) return( FALSE );
+
+    int nameLen = _data[ _position + 2 ];
+
+    record->channel           = _data[ _position ];
+    record->active            = (_data[ _position + 1 ] & CONFIG_ACTIVE) ? TRUE : FALSE;
+    record->description       = nameLen ? (const char *) &_data[ _position + 3 ] : NULL;
+    record->descriptionLength = nameLen;
+
+    _position += 3 + nameLen;
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::crc
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxConfigBlob::crc( void ) const
+{
+    if (_length == 0) return( 0 );
+    return( get32( 6 ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::decodeBase64
+//
+// Returns the decoded length, or -1 for a character that isn't base64 or a blob that won't fit
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxConfigBlob::decodeBase64( const char *text, uint8_t *data, int size )
+{
+    int      length = 0;
+    uint32_t group  = 0;
+    int      bits   = 0;
+
+    for (const char *cptr = text; *cptr && *cptr != '='; cptr++) {
+
+        const char *hit = strchr( _base64, *cptr );
+        if (hit == NULL) return( -1 );
+
+        group = (group << 6) | (uint32_t)(hit - _base64);
+        bits += 6;
+
+        if (bits >= 8) {
+            bits -= 8;
+            if (length == size) return( -1 );
+            data[ length++ ] = (group >> bits) & 0xFF;
+        }
+    }
+
+    return( length );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::get16
+//
+//------------------------------------------------------------------------------------------------------------
+uint16_t
+CxConfigBlob::get16( int offset ) const
+{
+    return( (uint16_t)( _data[ offset ] | (_data[ offset + 1 ] << 8) ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxConfigBlob::get32
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxConfigBlob::get32( int offset ) const
+{
+    return( (uint32_t) _data[ offset ]             | ((uint32_t) _data[ offset + 1 ] << 8) |
+            ((uint32_t) _data[ offset + 2 ] << 16) | ((uint32_t) _data[ offset + 3 ] << 24) );
+}
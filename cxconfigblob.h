@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxconfigblob.h
+//
+//  CxConfigBlob Class
+//
+//  A compact binary zone configuration that overrides the compiled in channel map without a
+//  reflash.  It arrives base64 encoded through the "cmd" function and is kept in EEPROM so it is
+//  back in force after a reset.  Records are read straight out of the blob, a record's description
+//  points into the blob rather than being copied out of it.
+//
+//  Layout, little endian:
+//
+//      0   uint16  CONFIG_MAGIC
+//      2   uint8   CONFIG_VERSION
+//      3   uint8   record count
+//      4   uint16  bytes of records that follow the header
+//      6   uint32  CRC32 of the records
+//     10   records, each
+//              uint8   channel
+//              uint8   flags, CONFIG_ACTIVE
+//              uint8   description length, zero keeps the compiled in description
+//              char[]  description, not terminated
+//
+//  Only the zones that differ from the channel map need a record.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxConfigBlob_h_
+#define _CxConfigBlob_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define CONFIG_MAGIC            0x435A      // "ZC"
+#define CONFIG_VERSION          1
+#define CONFIG_HEADER_BYTES     10
+#define CONFIG_MAX_BYTES        256
+#define CONFIG_CHANNELS         48
+#define CONFIG_NAME_MAX         40
+#define CONFIG_EEPROM_ADDRESS   64          // after the arming mode
+
+#define CONFIG_ACTIVE           0x01        // record flag, the zone is in use
+
+#define CONFIG_OK               0
+#define CONFIG_BAD_ENCODING     -1
+#define CONFIG_BAD_SIZE         -2
+#define CONFIG_BAD_MAGIC        -3
+#define CONFIG_BAD_VERSION      -4
+#define CONFIG_BAD_CRC          -5
+#define CONFIG_BAD_RECORD       -6
+
+
+//------------------------------------------------------------------------------------------------------------
+// struct CxConfigRecord
+//
+//------------------------------------------------------------------------------------------------------------
+struct CxConfigRecord
+{
+    int         channel;
+    int         active;
+    const char *description;                // points into the blob, NULL to keep the compiled in one
+    int         descriptionLength;
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxConfigBlob
+//
+//------------------------------------------------------------------------------------------------------------
+class CxConfigBlob
+{
+  public:
+
+    CxConfigBlob( void );
+    // constructor, an empty blob that overrides nothing
+
+    int decode( const char *text );
+    // take a base64 blob and validate it, returns CONFIG_OK or the reason it was refused.  A blob
+    // that is refused leaves this one empty
+
+    int load( void );
+    // read the blob saved in EEPROM and validate it, returns CONFIG_OK or the reason it was refused
+
+    void save( void ) const;
+    // keep the blob in EEPROM, an empty blob clears it
+
+    void clear( void );
+    // go back to overriding nothing
+
+    int validate( void ) const;
+    // check the header, crc and every record, returns CONFIG_OK or the first problem found
+
+    int records( void ) const;
+    // records in the blob
+
+    int first( CxConfigRecord *record );
+    int next( CxConfigRecord *record );
+    // walk the records, each returns FALSE once there are no more.  Only valid on a validated blob
+
+    uint32_t crc( void ) const;
+    // crc of the records, identifies the configuration in force
+
+  private:
+
+    static int decodeBase64( const char *text, uint8_t *data, int size );
+
+    uint16_t get16( int offset ) const;
+    uint32_t get32( int offset ) const;
+
+    uint8_t _data[ CONFIG_MAX_BYTES ];
+    int     _length;
+    int     _position;
+};
+
+
+#endif
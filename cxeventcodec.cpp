@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxeventcodec.cpp
+//
+//  CxEventCodec Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxeventcodec.h>
+
+static const char _base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// longest batch decode() will accept, a little over what encode() can produce
+
+#define DECODE_MAX_BYTES  (EVENT_CODEC_MAX_BYTES + 4)
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::CxEventCodec
+//
+//------------------------------------------------------------------------------------------------------------
+CxEventCodec::CxEventCodec( void )
+{
+    reset();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::reset
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxEventCodec::reset( void )
+{
+    _length       = 0;
+    _entries      = 0;
+    _lastSequence = 0;
+    _lastTime     = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::append
+//
+// If the worst case record might not fit the batch is full.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxEventCodec::append( unsigned long sequence, unsigned long time, uint64_t previousBits, int channel, int severity )
+{
+    if ((channel < 0) || (channel >= EVENT_CODEC_CHANNELS)) return( FALSE );
+    if ((severity < 0) || (severity >= EVENT_CODEC_SEVERITIES)) return( FALSE );
+    if (_length + EVENT_CODEC_RECORD_MAX > EVENT_CODEC_MAX_BYTES) return( FALSE );
+
+    if (_entries == 0) {
+
+        _buffer[0] = EVENT_CODEC_VERSION;
+        for (int i=0; i<4; i++) {
+            _buffer[1+i] = (sequence >> (8*i)) & 0xFF;
+            _buffer[5+i] = (time >> (8*i)) & 0xFF;
+        }
+        putState( &_buffer[9], previousBits );
+
+        _length       = EVENT_CODEC_HEADER;
+        _lastSequence = sequence;
+        _lastTime     = time;
+    }
+
+    int32_t timeDelta = (int32_t)(time - _lastTime);
+
+    putVarint( sequence - _lastSequence );
+    putVarint( ((uint32_t) timeDelta << 1) ^ (uint32_t)(timeDelta >> 31) );
+
+    _buffer[ _length++ ] = (uint8_t)( channel | (severity << 6) );
+
+    _lastSequence = sequence;
+    _lastTime     = time;
+    _entries++;
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::entries
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxEventCodec::entries( void ) const
+{
+    return( _entries );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::lastSequence
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxEventCodec::lastSequence( void ) const
+{
+    return( _lastSequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::encode
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxEventCodec::encode( char *text, int size ) const
+{
+    int needed = ((_length + 2) / 3) * 4;
+    if (needed + 1 > size) return( -1 );
+
+    int out = 0;
+
+    for (int i=0; i<_length; i+=3) {
+
+        uint32_t group = (uint32_t) _buffer[i] << 16;
+        if (i+1 < _length) group |= (uint32_t) _buffer[i+1] << 8;
+        if (i+2 < _length) group |= _buffer[i+2];
+
+        text[out++] = _base64[ (group >> 18) & 0x3F ];
+        text[out++] = _base64[ (group >> 12) & 0x3F ];
+        text[out++] = (i+1 < _length) ? _base64[ (group >> 6) & 0x3F ] : '=';
+        text[out++] = (i+2 < _length) ? _base64[ group & 0x3F ] : '=';
+    }
+
+    text[out] = 0;
+    return( out );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::decode
+//
+// Plain C++ with no Particle dependencies so the same code can expand batches on the receiving side.
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxEventCodec::decode( const char *text, CxEventRecordHandler handler, void *arg )
+{
+    uint8_t  data[ DECODE_MAX_BYTES ];
+    int      length = 0;
+    uint32_t group  = 0;
+    int      bits   = 0;
+
+    for (const char *cptr = text; *cptr && *cptr != '='; cptr++) {
+
+        const char *hit = strchr( _base64, *cptr );
+        if (hit == NULL) return( -1 );
+
+        group = (group << 6) | (uint32_t)(hit - _base64);
+        bits += 6;
+
+        if (bits >= 8) {
+            bits -= 8;
+            if (length == DECODE_MAX_BYTES) return( -1 );
+            data[ length++ ] = (group >> bits) & 0xFF;
+        }
+    }
+
+    if (length < EVENT_CODEC_HEADER || data[0] != EVENT_CODEC_VERSION) return( -1 );
+
+    unsigned long sequence = 0;
+    unsigned long time     = 0;
+
+    for (int i=0; i<4; i++) {
+        sequence |= (unsigned long) data[1+i] << (8*i);
+        time     |= (unsigned long) data[5+i] << (8*i);
+    }
+
+    uint64_t state = getState( &data[9] );
+    int pos   = EVENT_CODEC_HEADER;
+    int count = 0;
+
+    while (pos < length) {
+
+        uint32_t sequenceDelta;
+        uint32_t zigzag;
+
+        if (!getVarint( data, length, &pos, &sequenceDelta )) return( -1 );
+        if (!getVarint( data, length, &pos, &zigzag )) return( -1 );
+        if (pos >= length) return( -1 );
+
+        int channel  = data[ pos ] & 0x3F;
+        int severity = data[ pos ] >> 6;
+        pos++;
+
+        if (channel >= EVENT_CODEC_CHANNELS) return( -1 );
+
+        sequence += sequenceDelta;
+        time     += (int32_t)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+        state    ^= 1ULL << channel;
+
+        if (handler) handler( sequence, time, channel, severity, state, arg );
+        count++;
+    }
+
+    return( count );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::putVarint
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxEventCodec::putVarint( uint32_t value )
+{
+    int start = _length;
+
+    while (value >= 0x80) {
+        _buffer[ _length++ ] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    _buffer[ _length++ ] = value;
+
+    return( _length - start );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::getVarint
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxEventCodec::getVarint( const uint8_t *data, int length, int *pos, uint32_t *value )
+{
+    uint32_t result = 0;
+
+    for (int shift=0; shift<35; shift+=7) {
+
+        if (*pos >= length) return( FALSE );
+
+        uint8_t b = data[ (*pos)++ ];
+        result |= (uint32_t)(b & 0x7F) << shift;
+
+        if ((b & 0x80) == 0) {
+            *value = result;
+            return( TRUE );
+        }
+    }
+
+    return( FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::putState
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxEventCodec::putState( uint8_t *data, uint64_t bits )
+{
+    for (int i=0; i<EVENT_CODEC_STATE_BYTES; i++) {
+        data[i] = (bits >> (8*i)) & 0xFF;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxEventCodec::getState
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+uint64_t
+CxEventCodec::getState( const uint8_t *data )
+{
+    uint64_t bits = 0;
+
+    for (int i=0; i<EVENT_CODEC_STATE_BYTES; i++) {
+        bits |= (uint64_t) data[i] << (8*i);
+    }
+
+    return( bits );
+}
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxeventcodec.h
+//
+//  CxEventCodec Class
+//
+//  A compact alternative to one ~250 byte json payload per zone transition.  A batch starts with the
+//  packed zone state before its first record, then each record carries one zone transition in about
+//  three bytes.  The batch is sent as base64 so a single publish can carry a whole burst of transitions.
+//
+//  Binary layout, all multi byte fields little endian:
+//
+//      byte     version            EVENT_CODEC_VERSION
+//      uint32   sequence           sequence number of the first record
+//      uint32   time               seconds from epoch of the first record
+//      6 bytes  base state         packed activated bits before the first record, bit n is channel n
+//
+//      then for each record
+//
+//      varint   sequence delta     from the previous record, 0 for the first
+//      varint   time delta         zigzag encoded seconds from the previous record, 0 for the first
+//      byte     zone               channel in the low 6 bits, severity (0 to 3) in the top 2
+//
+//  decode() walks a batch and hands each record back with the state after it.  Every transition keeps
+//  its own sequence number and severity, so the receiving side can rebuild the per zone messages
+//  exactly as they would have been sent one by one (test/compact_decode does this).  The one field
+//  that isn't carried is free_memory.
+//
+//  Uncomment USE_COMPACT_EVENTS to send access_changed events in this form.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+//#define USE_COMPACT_EVENTS TRUE
+
+#include <stdint.h>
+
+#ifndef _CxEventCodec_h_
+#define _CxEventCodec_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define EVENT_CODEC_VERSION     2
+#define EVENT_CODEC_STATE_BYTES 6
+#define EVENT_CODEC_HEADER      (1 + 4 + 4 + EVENT_CODEC_STATE_BYTES)
+#define EVENT_CODEC_RECORD_MAX  (5 + 5 + 1) // both varints at their longest and the zone byte
+#define EVENT_CODEC_CHANNELS    (EVENT_CODEC_STATE_BYTES * 8)
+#define EVENT_CODEC_SEVERITIES  4
+#define EVENT_CODEC_MAX_BYTES   380         // base64 of this plus the json wrapper and key fits one publish
+#define EVENT_CODEC_BATCH_MS    500         // longest a record waits for company before it is sent
+
+typedef void (*CxEventRecordHandler)( unsigned long sequence, unsigned long time, int channel, 
+                                      int severity, uint64_t stateBits, void *arg );
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxEventCodec
+//
+//------------------------------------------------------------------------------------------------------------
+class CxEventCodec
+{
+  public:
+
+    CxEventCodec( void );
+    // constructor
+
+    void reset( void );
+    // empty the batch
+
+    int append( unsigned long sequence, unsigned long time, uint64_t previousBits, int channel, int severity );
+    // add the transition of one channel, previousBits is the state before it and only matters for the
+    // first record.  Returns FALSE if the batch has no room or the channel or severity is out of range
+
+    int entries( void ) const;
+    // records in the batch
+
+    unsigned long lastSequence( void ) const;
+    // sequence of the newest record
+
+    int encode( char *text, int size ) const;
+    // base64 of the batch, returns the length or -1 if it doesn't fit
+
+    static int decode( const char *text, CxEventRecordHandler handler, void *arg );
+    // walk a base64 batch calling handler for each record, returns the record count or -1
+
+  private:
+
+    int putVarint( uint32_t value );
+
+    static int getVarint( const uint8_t *data, int length, int *pos, uint32_t *value );
+
+    static void putState( uint8_t *data, uint64_t bits );
+
+    static uint64_t getState( const uint8_t *data );
+
+    uint8_t       _buffer[ EVENT_CODEC_MAX_BYTES ];
+    int           _length;
+    int           _entries;
+    unsigned long _lastSequence;
+    unsigned long _lastTime;
+};
+
+
+#endif
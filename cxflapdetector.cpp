@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxflapdetector.cpp
+//
+//  CxFlapDetector Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxflapdetector.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::CxFlapDetector
+//
+//------------------------------------------------------------------------------------------------------------
+CxFlapDetector::CxFlapDetector( void )
+: _flappingBits( 0 ),
+  _suppressed( 0 )
+{
+    memset( _zones, 0, sizeof( _zones ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::transition
+//
+// Once the ring is full the slot after the newest entry holds the oldest of the last FLAP_THRESHOLD
+// transitions, if that is inside the window the zone is flapping.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxFlapDetector::transition( int channel, unsigned long nowMillis )
+{
+    if (channel < 0 || channel >= FLAP_CHANNELS) return( FLAP_NONE );
+
+    Zone    *z   = &_zones[ channel ];
+    uint64_t bit = 1ULL << channel;
+
+    z->times[ z->next ] = nowMillis;
+    z->next = (z->next + 1) % FLAP_THRESHOLD;
+    if (z->count < FLAP_THRESHOLD) z->count++;
+
+    if (_flappingBits & bit) {
+        _suppressed++;
+        return( FLAP_SUPPRESSED );
+    }
+
+    if (z->count == FLAP_THRESHOLD && nowMillis - z->times[ z->next ] <= FLAP_WINDOW_MS) {
+        _flappingBits |= bit;
+        _suppressed++;
+        return( FLAP_STARTED );
+    }
+
+    return( FLAP_NONE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::expire
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxFlapDetector::expire( unsigned long nowMillis )
+{
+    uint64_t cleared = 0;
+    uint64_t pending = _flappingBits;
+
+    while (pending) {
+
+        int channel = __builtin_ctzll( pending );
+        pending &= pending - 1;
+
+        Zone *z = &_zones[ channel ];
+        uint32_t newest = z->times[ (z->next + FLAP_THRESHOLD - 1) % FLAP_THRESHOLD ];
+
+        if (nowMillis - newest >= FLAP_QUIET_MS) {
+            cleared  |= 1ULL << channel;
+            z->count  = 0;
+        }
+    }
+
+    _flappingBits &= ~cleared;
+    return( cleared );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::clear
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxFlapDetector::clear( int channel )
+{
+    if (channel < 0 || channel >= FLAP_CHANNELS) return;
+
+    memset( &_zones[ channel ], 0, sizeof( Zone ));
+    _flappingBits &= ~(1ULL << channel);
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::flappingBits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxFlapDetector::flappingBits( void ) const
+{
+    return( _flappingBits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxFlapDetector::suppressed
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxFlapDetector::suppressed( void ) const
+{
+    return( _suppressed );
+}
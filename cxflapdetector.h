@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxflapdetector.h
+//
+//  CxFlapDetector Class
+//
+//  Spots zones that change state too often, a reed switch that has slipped out of line can toggle
+//  on every scan and use up the publish rate limit real events need.  Each zone keeps the times of
+//  its last FLAP_THRESHOLD transitions in a small ring, so deciding whether the newest transition
+//  puts it over FLAP_THRESHOLD in FLAP_WINDOW_MS is a single compare.  A flapping zone stays
+//  flapping until it has been quiet for FLAP_QUIET_MS, which is longer than the window so a switch
+//  on the edge doesn't bounce in and out.
+//
+//  Nothing runs for a zone that doesn't change, expire() only looks at zones that are flapping.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxFlapDetector_h_
+#define _CxFlapDetector_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define FLAP_CHANNELS        48
+#define FLAP_THRESHOLD       6              // transitions ...
+#define FLAP_WINDOW_MS       60000          // ... inside this window make a zone flapping
+#define FLAP_QUIET_MS        300000         // quiet time before a flapping zone is trusted again
+
+#define FLAP_NONE            0              // publish the transition as usual
+#define FLAP_STARTED         1              // the zone just started flapping, send the notice instead
+#define FLAP_SUPPRESSED      2              // the zone is flapping, don't publish
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxFlapDetector
+//
+//------------------------------------------------------------------------------------------------------------
+class CxFlapDetector
+{
+  public:
+
+    CxFlapDetector( void );
+    // constructor
+
+    int transition( int channel, unsigned long nowMillis );
+    // count a transition, returns FLAP_NONE, FLAP_STARTED or FLAP_SUPPRESSED
+
+    uint64_t expire( unsigned long nowMillis );
+    // clear zones that have been quiet long enough, returns their bits
+
+    void clear( int channel );
+    // forget a zone's history, for a zone taken out of the system
+
+    uint64_t flappingBits( void ) const;
+    // zones currently flapping
+
+    unsigned long suppressed( void ) const;
+    // transitions held back since reset
+
+  private:
+
+    struct Zone {
+        uint32_t times[ FLAP_THRESHOLD ];   // millis() of the latest transitions, oldest at next
+        uint8_t  next;
+        uint8_t  count;
+    };
+
+    Zone          _zones[ FLAP_CHANNELS ];
+    uint64_t      _flappingBits;
+    unsigned long _suppressed;
+};
+
+
+#endif
@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxheapstats.cpp
+//
+//  CxHeapStats Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cxheapstats.h>
+
+// size of the header in front of each block, 8 keeps the caller's memory double word aligned
+
+#define HEAP_HEADER_SIZE 8
+
+volatile unsigned long CxHeapStats::_allocations     = 0;
+volatile unsigned long CxHeapStats::_frees           = 0;
+volatile unsigned long CxHeapStats::_bytesInUse      = 0;
+volatile unsigned long CxHeapStats::_peakBytes       = 0;
+volatile unsigned long CxHeapStats::_iterationAllocs = 0;
+volatile unsigned long CxHeapStats::_iterationBytes  = 0;
+volatile unsigned long CxHeapStats::_iterationPeak   = 0;
+
+unsigned long CxHeapStats::_maxIterationAllocs = 0;
+unsigned long CxHeapStats::_maxIterationBytes  = 0;
+unsigned long CxHeapStats::_maxIterationPeak   = 0;
+unsigned long CxHeapStats::_overruns           = 0;
+unsigned long CxHeapStats::_budget             = HEAP_ITERATION_BUDGET;
+
+
+#ifdef USE_HEAP_STATS
+//------------------------------------------------------------------------------------------------------------
+// global operator new and delete
+//
+//------------------------------------------------------------------------------------------------------------
+void *operator new( size_t size )                 { return( CxHeapStats::allocate( size )); }
+void *operator new[]( size_t size )               { return( CxHeapStats::allocate( size )); }
+void  operator delete( void *ptr )                { CxHeapStats::release( ptr ); }
+void  operator delete[]( void *ptr )              { CxHeapStats::release( ptr ); }
+void  operator delete( void *ptr, size_t )        { CxHeapStats::release( ptr ); }
+void  operator delete[]( void *ptr, size_t )      { CxHeapStats::release( ptr ); }
+#endif
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::allocate
+//
+// new can be called from the publisher thread as well as the application thread so the counters
+// are updated inside an atomic block.
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void *
+CxHeapStats::allocate( size_t size )
+{
+    char *block = (char *) malloc( size + HEAP_HEADER_SIZE );
+    if (block == NULL) return( NULL );
+
+    *((size_t *) block) = size;
+
+    ATOMIC_BLOCK() {
+        _allocations++;
+        _bytesInUse += size;
+        if (_bytesInUse > _peakBytes) _peakBytes = _bytesInUse;
+
+        _iterationAllocs++;
+        _iterationBytes += size;
+        if (_bytesInUse > _iterationPeak) _iterationPeak = _bytesInUse;
+    }
+
+    return( block + HEAP_HEADER_SIZE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::release
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxHeapStats::release( void *ptr )
+{
+    if (ptr == NULL) return;
+
+    char *block = ((char *) ptr) - HEAP_HEADER_SIZE;
+    size_t size = *((size_t *) block);
+
+    ATOMIC_BLOCK() {
+        _frees++;
+        _bytesInUse -= size;
+    }
+
+    free( block );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::beginIteration
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxHeapStats::beginIteration( void )
+{
+    ATOMIC_BLOCK() {
+        _iterationAllocs = 0;
+        _iterationBytes  = 0;
+        _iterationPeak   = _bytesInUse;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::endIteration
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxHeapStats::endIteration( int steadyState )
+{
+    if (_iterationAllocs > _maxIterationAllocs) _maxIterationAllocs = _iterationAllocs;
+    if (_iterationBytes  > _maxIterationBytes)  _maxIterationBytes  = _iterationBytes;
+    if (_iterationPeak   > _maxIterationPeak)   _maxIterationPeak   = _iterationPeak;
+
+    if (steadyState && (_iterationAllocs > _budget)) {
+        _overruns++;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::setBudget
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxHeapStats::setBudget( unsigned long allocations )
+{
+    _budget = allocations;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::resetWindow
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxHeapStats::resetWindow( void )
+{
+    _maxIterationAllocs = 0;
+    _maxIterationBytes  = 0;
+    _maxIterationPeak   = 0;
+    _overruns           = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::allocations
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+unsigned long
+CxHeapStats::allocations( void )
+{
+    return( _allocations );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::bytesInUse
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+unsigned long
+CxHeapStats::bytesInUse( void )
+{
+    return( _bytesInUse );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::peakBytes
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+unsigned long
+CxHeapStats::peakBytes( void )
+{
+    return( _peakBytes );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::overruns
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+unsigned long
+CxHeapStats::overruns( void )
+{
+    return( _overruns );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHeapStats::format
+//
+// The loop_ figures are the worst single pass since the last resetWindow().
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxHeapStats::format( char *buffer, int size )
+{
+    return( snprintf( buffer, size,
+        "[%lu,%lu,%lu,%lu,%lu,%lu,%lu]",
+        _bytesInUse, _peakBytes, _allocations,
+        _maxIterationAllocs, _maxIterationBytes, _maxIterationPeak, _overruns ));
+}
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxheapstats.h
+//
+//  CxHeapStats Class
+//
+//  Replaces the global operator new and delete so every C++ allocation in the application is counted.
+//  Each block carries a small header holding its size so frees can be accounted in bytes.  The main
+//  loop brackets each pass with beginIteration() / endIteration() which gives per iteration counts and
+//  a check against an allocation budget.  In steady state (no zone changes, no reports going out) the
+//  loop should not allocate at all, any pass that does is counted as over budget.
+//
+//  Off by default, production builds keep the runtime's own new and delete and their heartbeat has no
+//  heap figures.  Uncomment USE_HEAP_STATS below for a diagnostic build, which adds
+//  "heap":[in_use,peak,allocs,loop_allocs,loop_bytes,loop_peak,over_budget] to the heartbeat with the
+//  loop_ figures the worst single pass since the heartbeat before.  test/alarmsystem_heap_test runs
+//  the firmware on the host with it on and fails if a steady state pass allocates.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+//#define USE_HEAP_STATS TRUE
+
+#include <Particle.h>
+
+#ifndef _CxHeapStats_h_
+#define _CxHeapStats_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+// allocations allowed in a steady state pass through the loop
+#define HEAP_ITERATION_BUDGET 0
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxHeapStats
+//
+//------------------------------------------------------------------------------------------------------------
+class CxHeapStats
+{
+  public:
+
+    static void *allocate( size_t size );
+    // counted replacement for operator new
+
+    static void release( void *ptr );
+    // counted replacement for operator delete
+
+    static void beginIteration( void );
+    // start counting a new pass through the loop
+
+    static void endIteration( int steadyState );
+    // close the pass, a steady state pass over budget is counted as an overrun
+
+    static void setBudget( unsigned long allocations );
+    // allocations allowed per steady state pass
+
+    static void resetWindow( void );
+    // clear the worst case figures, called after each heartbeat
+
+    static unsigned long allocations( void );   // total allocations since boot
+    static unsigned long bytesInUse( void );    // bytes currently held by new
+    static unsigned long peakBytes( void );     // most bytes ever held at once
+    static unsigned long overruns( void );      // steady state passes over budget since the last reset
+
+    static int format( char *buffer, int size );
+    // [in_use,peak,allocs,loop_allocs,loop_bytes,loop_peak,over_budget], an array to keep the heartbeat small
+
+  private:
+
+    static volatile unsigned long _allocations;
+    static volatile unsigned long _frees;
+    static volatile unsigned long _bytesInUse;
+    static volatile unsigned long _peakBytes;
+
+    static volatile unsigned long _iterationAllocs;
+    static volatile unsigned long _iterationBytes;
+    static volatile unsigned long _iterationPeak;
+
+    static unsigned long _maxIterationAllocs;
+    static unsigned long _maxIterationBytes;
+    static unsigned long _maxIterationPeak;
+    static unsigned long _overruns;
+    static unsigned long _budget;
+};
+
+
+#endif
@@ -0,0 +1,265 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxhistory.cpp
+//
+//  CxHistory Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <cxhistory.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::CxHistory
+//
+//------------------------------------------------------------------------------------------------------------
+CxHistory::CxHistory( void )
+{
+    clear();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::clear
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxHistory::clear( void )
+{
+    for (int b=0; b<HISTORY_BLOCKS; b++) {
+        _blocks[ b ].baseTime = 0;
+        _blocks[ b ].count    = 0;
+        _blocks[ b ].used     = 0;
+    }
+
+    _newest     = 0;
+    _blocksUsed = 0;
+    _lastTime   = 0;
+    _lastDelta  = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::append
+//
+// A transition that might not fit starts a new block, which takes over the oldest block once the
+// ring has gone all the way round.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxHistory::append( unsigned long time, int channel, int activated )
+{
+    Block *block = &_blocks[ _newest ];
+
+    if (_blocksUsed == 0 || block->used + HISTORY_RECORD_MAX > HISTORY_BLOCK_BYTES) {
+
+        if (_blocksUsed) _newest = (_newest + 1) % HISTORY_BLOCKS;
+        if (_blocksUsed < HISTORY_BLOCKS) _blocksUsed++;
+
+        block = &_blocks[ _newest ];
+        block->baseTime = time;
+        block->count    = 0;
+        block->used     = 0;
+
+        _lastTime  = time;
+        _lastDelta = 0;
+    }
+
+    int32_t delta = (int32_t)((uint32_t) time - _lastTime);
+    int32_t dod   = delta - _lastDelta;
+
+    block->used += putVarint( &block->data[ block->used ], ((uint32_t) dod << 1) ^ (uint32_t)(dod >> 31) );
+    block->used += putVarint( &block->data[ block->used ], ((uint32_t) channel << 1) | (activated ? 1 : 0) );
+    block->count++;
+
+    _lastTime  = time;
+    _lastDelta = delta;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::entries
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxHistory::entries( void ) const
+{
+    int total = 0;
+
+    for (int i=0; i<_blocksUsed; i++) {
+        total += _blocks[ blockAt( i ) ].count;
+    }
+
+    return( total );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::bytesUsed
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxHistory::bytesUsed( void ) const
+{
+    int total = 0;
+
+    for (int i=0; i<_blocksUsed; i++) {
+        total += _blocks[ blockAt( i ) ].used;
+    }
+
+    return( total );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::last
+//
+// Transitions can only be decoded oldest first, so the matches are counted first and the second
+// pass skips all but the newest count of them.  For every zone the block counts are enough, for
+// one zone the blocks have to be decoded twice.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxHistory::last( int count, int channel, CxHistoryHandler handler, void *arg ) const
+{
+    int matches = 0;
+
+    for (int i=0; i<_blocksUsed; i++) {
+        const Block *block = &_blocks[ blockAt( i ) ];
+        matches += (channel == HISTORY_ALL_ZONES) ? block->count : decode( block, channel, 0, NULL, NULL );
+    }
+
+    int skip = (matches > count) ? matches - count : 0;
+    int sent = 0;
+
+    for (int i=0; i<_blocksUsed; i++) {
+
+        const Block *block = &_blocks[ blockAt( i ) ];
+
+        if (channel == HISTORY_ALL_ZONES && skip >= block->count) {
+            skip -= block->count;
+            continue;
+        }
+
+        int found = decode( block, channel, skip, handler, arg );
+        sent += (found > skip) ? found - skip : 0;
+        skip  = (skip > found) ? skip - found : 0;
+    }
+
+    return( sent );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::decode
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxHistory::decode( const Block *block, int channel, int skip, CxHistoryHandler handler, void *arg ) const
+{
+    uint32_t time    = block->baseTime;
+    int32_t  delta   = 0;
+    int      offset  = 0;
+    int      matches = 0;
+
+    for (int r=0; r<block->count; r++) {
+
+        uint32_t zz;
+        uint32_t zone;
+
+        offset += getVarint( &block->data[ offset ], block->used - offset, &zz );
+        offset += getVarint( &block->data[ offset ], block->used - offset, &zone );
+
+        delta += (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+        time  += delta;
+
+        int c = zone >> 1;
+        if (channel != HISTORY_ALL_ZONES && c != channel) continue;
+
+        if (matches >= skip && handler) {
+            handler( time, c, zone & 1, arg );
+        }
+
+        matches++;
+    }
+
+    return( matches );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::blockAt
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxHistory::blockAt( int i ) const
+{
+    return( (_newest - _blocksUsed + 1 + i + HISTORY_BLOCKS) % HISTORY_BLOCKS );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::putVarint
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxHistory::putVarint( uint8_t *data, uint32_t value )
+{
+    int len = 0;
+
+    while (value >= 0x80) {
+        data[ len++ ] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    data[ len++ ] = (uint8_t) value;
+    return( len );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxHistory::getVarint
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxHistory::getVarint( const uint8_t *data, int len, uint32_t *value )
+{
+    uint32_t result = 0;
+    int      shift  = 0;
+    int      i      = 0;
+
+    while (i < len && i < 5) {
+        uint8_t b = data[ i++ ];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+        shift += 7;
+    }
+
+    *value = result;
+    return( i );
+}
@@ -0,0 +1,113 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxhistory.h
+//
+//  CxHistory Class
+//
+//  A ring of recent zone transitions kept on the device.  Transitions are packed into fixed size
+//  blocks as varints: the time as a delta of delta against the previous two transitions (zig-zag
+//  so it can go backwards when the clock is set) followed by (channel << 1 | activated).  Ordinary
+//  activity takes two or three bytes a transition, so the default 4KB holds well over a thousand
+//  transitions, days of normal use.  When the ring is full the oldest block is dropped whole.
+//
+//  Each block starts from an absolute time so it can be decoded without the blocks before it.  The
+//  class has no Particle dependency so the same code can decode a dumped ring on the host.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#ifndef _CxHistory_h_
+#define _CxHistory_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define HISTORY_BLOCKS        16
+#define HISTORY_BLOCK_BYTES   256
+#define HISTORY_RECORD_MAX    10            // two 5 byte varints
+#define HISTORY_ALL_ZONES     -1
+
+typedef void (*CxHistoryHandler)( unsigned long time, int channel, int activated, void *arg );
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxHistory
+//
+//------------------------------------------------------------------------------------------------------------
+class CxHistory
+{
+  public:
+
+    CxHistory( void );
+    // constructor
+
+    void append( unsigned long time, int channel, int activated );
+    // add a transition, time in seconds from epoch
+
+    int entries( void ) const;
+    // transitions currently held
+
+    int bytesUsed( void ) const;
+    // encoded bytes currently held, for working out the compression
+
+    int last( int count, int channel, CxHistoryHandler handler, void *arg ) const;
+    // call handler, oldest first, for the newest count transitions.  channel limits it to one zone
+    // or HISTORY_ALL_ZONES for every zone.  Returns the number of transitions handed over
+
+    void clear( void );
+
+  private:
+
+    struct Block {
+        uint32_t baseTime;                  // time of the first transition in the block
+        uint16_t count;
+        uint16_t used;
+        uint8_t  data[ HISTORY_BLOCK_BYTES ];
+    };
+
+    int decode( const Block *block, int channel, int skip, CxHistoryHandler handler, void *arg ) const;
+    // walk one block, skipping the first skip matches.  Returns the number of matches
+
+    int blockAt( int i ) const;
+    // index of the i'th oldest block in use
+
+    static int putVarint( uint8_t *data, uint32_t value );
+    static int getVarint( const uint8_t *data, int len, uint32_t *value );
+
+    Block    _blocks[ HISTORY_BLOCKS ];
+    int      _newest;                       // block being filled
+    int      _blocksUsed;
+    uint32_t _lastTime;
+    int32_t  _lastDelta;
+};
+
+
+#endif
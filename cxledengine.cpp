@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxledengine.cpp
+//
+//  CxLedEngine Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxledengine.h>
+
+// brightness of each pattern at each step, as a fraction of LED_MAX_LEVEL
+static const uint8_t patternTable[ LED_PATTERNS ][ LED_PATTERN_STEPS ] = {
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },                                             // LED_OFF
+    { LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL,      // LED_STEADY
+      LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL,
+      LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL },
+    { LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL, LED_MAX_LEVEL,      // LED_SLOW_BLINK
+      LED_MAX_LEVEL, LED_MAX_LEVEL, 0, 0, 0, 0, 0, 0, 0, 0 },
+    { LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0,                        // LED_FAST_BLINK
+      LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0, LED_MAX_LEVEL, 0 },
+    { LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL,      // LED_DIM
+      LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL,
+      LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL, LED_DIM_LEVEL }
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::CxLedEngine
+//
+//------------------------------------------------------------------------------------------------------------
+CxLedEngine::CxLedEngine( SN74HC595 *chain )
+: _chain( chain ),
+  _timer( LED_TICK_MS, &CxLedEngine::tick, *this ),
+  _dirty( TRUE ),
+  _front( 0 ),
+  _shownMillis( 0 ),
+  _shifts( 0 ),
+  _plane( LED_BAM_BITS - 1 ),
+  _ticksLeft( 0 ),
+  _step( -1 ),
+  _frameMicros( 0 ),
+  _maxFrameMicros( 0 )
+{
+    for (int led=0; led<LED_COUNT; led++) {
+        _patterns[ led ]   = LED_OFF;
+        _brightness[ led ] = LED_MAX_LEVEL;
+    }
+
+    for (int p=0; p<LED_BAM_BITS; p++) {
+        _planes[ p ] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::begin
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::begin( void )
+{
+    // force the first frame out whatever the chain powered up with
+    _shownMillis = millis() - LED_REFRESH_MS;
+
+    _timer.start();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::setPattern
+//
+// Only flags the change, the timer picks it up at the start of its next cycle.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::setPattern( int led, int pattern )
+{
+    if (led < 0 || led >= LED_COUNT || pattern < 0 || pattern >= LED_PATTERNS) return;
+    if (_patterns[ led ] == pattern) return;
+
+    _patterns[ led ] = pattern;
+    _dirty = TRUE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::setBrightness
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::setBrightness( int led, int level )
+{
+    if (led < 0 || led >= LED_COUNT) return;
+
+    if (level < 0) level = 0;
+    if (level > LED_MAX_LEVEL) level = LED_MAX_LEVEL;
+    if (_brightness[ led ] == level) return;
+
+    _brightness[ led ] = level;
+    _dirty = TRUE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::pattern
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxLedEngine::pattern( int led ) const
+{
+    if (led < 0 || led >= LED_COUNT) return( LED_OFF );
+    return( _patterns[ led ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::frameMicros
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxLedEngine::frameMicros( void ) const
+{
+    return( _frameMicros );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::maxFrameMicros
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxLedEngine::maxFrameMicros( void ) const
+{
+    return( _maxFrameMicros );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::shifts
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxLedEngine::shifts( void ) const
+{
+    return( _shifts );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::tick
+//
+// Runs every LED_TICK_MS on the timer thread.  Most ticks just count down the plane on show, when
+// it has had its 2^n ticks the next plane is due.  It is only shifted out if it differs from the
+// front buffer or the refresh is due.  Patterns are re-rendered at the start of a cycle, so a cycle
+// never mixes planes from two different steps.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::tick( void )
+{
+    if (--_ticksLeft > 0) return;
+
+    if (++_plane >= LED_BAM_BITS) {
+
+        _plane = 0;
+
+        int step = (millis() / LED_PATTERN_STEP_MS) % LED_PATTERN_STEPS;
+
+        if (step != _step || _dirty) {
+            _step  = step;
+            _dirty = FALSE;
+            render();
+        }
+    }
+
+    _ticksLeft = 1 << _plane;
+
+    uint64_t      next = _planes[ _plane ];
+    unsigned long now  = millis();
+
+    if (next == _front && (now - _shownMillis) < LED_REFRESH_MS) return;
+
+    unsigned long start = micros();
+    shiftPlane( next );
+    _frameMicros = micros() - start;
+
+    if (_frameMicros > _maxFrameMicros) _maxFrameMicros = _frameMicros;
+
+    _front       = next;
+    _shownMillis = now;
+    _shifts++;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::render
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::render( void )
+{
+    uint64_t planes[ LED_BAM_BITS ];
+
+    for (int p=0; p<LED_BAM_BITS; p++) {
+        planes[ p ] = 0;
+    }
+
+    for (int led=0; led<LED_COUNT; led++) {
+
+        int level = patternTable[ _patterns[ led ] ][ _step ] * _brightness[ led ] / LED_MAX_LEVEL;
+
+        for (int p=0; p<LED_BAM_BITS; p++) {
+            if (level & (1 << p)) planes[ p ] |= (1ULL << led);
+        }
+    }
+
+    for (int p=0; p<LED_BAM_BITS; p++) {
+        _planes[ p ] = planes[ p ];
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLedEngine::shiftPlane
+//
+// Bit 0 goes out first, the same order the LED bits have always been written in.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLedEngine::shiftPlane( uint64_t bits )
+{
+    for (int led=0; led<LED_COUNT; led++) {
+        _chain->writeBit( (bits >> led) & 1 );
+    }
+
+    _chain->latch_output();
+}
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxledengine.h
+//
+//  CxLedEngine Class
+//
+//  Drives the front panel LED's from a software timer so they no longer depend on how fast loop()
+//  runs.  Each LED has a brightness and plays a pattern from a small table (steady, slow blink, fast
+//  blink, dim), every LED steps through its pattern on the same clock so blinking zones stay in
+//  phase.
+//
+//  Brightness uses binary angle modulation.  A level of LED_BAM_BITS bits is split into bit planes
+//  and plane n is held on the chain for 2^n ticks, so each LED is lit for a share of every cycle
+//  proportional to its level while the chain is only shifted once per plane rather than once per
+//  tick.  With 3 bits and a 1ms tick a cycle is 7ms, fast enough not to flicker.
+//
+//  Frames are double buffered.  The planes are rendered into a back buffer and a plane is only
+//  shifted out when it differs from the front buffer, what the chain is latched on now.  When every
+//  LED is fully on or off all the planes are the same and the chain sits untouched apart from a
+//  refresh every LED_REFRESH_MS, in case a glitch upset the registers.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <SN74HC595.h>
+
+#ifndef _CxLedEngine_h_
+#define _CxLedEngine_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define LED_COUNT             48
+#define LED_BAM_BITS          3
+#define LED_MAX_LEVEL         ((1 << LED_BAM_BITS) - 1)
+#define LED_DIM_LEVEL         1
+#define LED_TICK_MS           1         // one tick of the least significant plane
+#define LED_PATTERN_STEPS     16
+#define LED_PATTERN_STEP_MS   125       // a pattern repeats every two seconds
+#define LED_REFRESH_MS        1000      // longest the chain goes without being shifted
+
+enum CxLedPattern {
+    LED_OFF,
+    LED_STEADY,
+    LED_SLOW_BLINK,                     // one second on, one second off
+    LED_FAST_BLINK,                     // four flashes a second
+    LED_DIM,
+    LED_PATTERNS
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxLedEngine
+//
+//------------------------------------------------------------------------------------------------------------
+class CxLedEngine
+{
+  public:
+
+    CxLedEngine( SN74HC595 *chain );
+    // constructor, chain is the output shift register bank the LED's hang off
+
+    void begin( void );
+    // start refreshing, call once the chain's pins are set up
+
+    void setPattern( int led, int pattern );
+    // the pattern an LED plays, led is its bit position in the chain
+
+    void setBrightness( int led, int level );
+    // how bright the LED is when its pattern says on, 0 to LED_MAX_LEVEL.  Defaults to LED_MAX_LEVEL
+
+    int pattern( int led ) const;
+
+    unsigned long frameMicros( void ) const;
+    // time the last plane took to shift out and latch
+
+    unsigned long maxFrameMicros( void ) const;
+    // longest a plane has taken
+
+    unsigned long shifts( void ) const;
+    // planes actually shifted out since begin()
+
+  private:
+
+    void tick( void );
+    // timer callback, shifts out the next plane when its time comes
+
+    void render( void );
+    // work out the bit planes for the current pattern step
+
+    void shiftPlane( uint64_t bits );
+
+    SN74HC595    *_chain;
+    Timer         _timer;
+    uint8_t       _patterns[ LED_COUNT ];
+    uint8_t       _brightness[ LED_COUNT ];
+    volatile int  _dirty;               // a pattern or brightness changed since the last render
+    uint64_t      _planes[ LED_BAM_BITS ];  // back buffer
+    uint64_t      _front;                   // what the chain is showing
+    unsigned long _shownMillis;             // when the chain was last shifted
+    unsigned long _shifts;
+    int           _plane;
+    int           _ticksLeft;
+    int           _step;
+    unsigned long _frameMicros;
+    unsigned long _maxFrameMicros;
+};
+
+
+#endif
@@ -0,0 +1,215 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxloopprofile.cpp
+//
+//  CxLoopProfile Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <cxloopprofile.h>
+
+static const char *_phaseNames[ PHASE_COUNT ] = {
+    "loop", "scan", "relay", "timers", "publish", "led"
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::CxLoopProfile
+//
+//------------------------------------------------------------------------------------------------------------
+CxLoopProfile::CxLoopProfile( void )
+{
+    reset();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::start
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxLoopProfile::start( void ) const
+{
+    return( System.ticks() );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::record
+//
+// The cycle counter wraps every 35 seconds or so at 120MHz, the unsigned difference is correct
+// across one wrap which is far longer than any phase.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLoopProfile::record( int phase, uint32_t startTicks )
+{
+    uint32_t us = (System.ticks() - startTicks) / System.ticksPerMicrosecond();
+
+    if (us < _min[ phase ]) _min[ phase ] = us;
+    if (us > _max[ phase ]) _max[ phase ] = us;
+
+    _sum[ phase ] += us;
+    _count[ phase ]++;
+
+    int bucket = 0;
+    uint32_t v = us >> 4;
+
+    while (v && bucket < PROFILE_HIST_BUCKETS-1) {
+        v >>= 2;
+        bucket++;
+    }
+
+    if (_hist[ phase ][ bucket ] != 0xFFFF) _hist[ phase ][ bucket ]++;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::reset
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxLoopProfile::reset( void )
+{
+    for (int p=0; p<PHASE_COUNT; p++) {
+        _min[p]   = 0xFFFFFFFF;
+        _max[p]   = 0;
+        _sum[p]   = 0;
+        _count[p] = 0;
+        for (int b=0; b<PROFILE_HIST_BUCKETS; b++) {
+            _hist[p][b] = 0;
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::minUs
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxLoopProfile::minUs( int phase ) const
+{
+    if (_count[ phase ] == 0) return( 0 );
+    return( _min[ phase ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::avgUs
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxLoopProfile::avgUs( int phase ) const
+{
+    if (_count[ phase ] == 0) return( 0 );
+    return( _sum[ phase ] / _count[ phase ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::maxUs
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxLoopProfile::maxUs( int phase ) const
+{
+    return( _max[ phase ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::formatSummary
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxLoopProfile::formatSummary( char *buffer, int size ) const
+{
+    int len = snprintf( buffer, size, "[" );
+
+    for (int p=0; p<PHASE_COUNT && len < size; p++) {
+        len += snprintf( buffer + len, size - len, "%s[%lu,%lu,%lu]",
+                         p ? "," : "",
+                         (unsigned long) minUs( p ), (unsigned long) avgUs( p ), (unsigned long) maxUs( p ) );
+    }
+
+    if (len < size) len += snprintf( buffer + len, size - len, "]" );
+    return( len );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::formatHistogram
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxLoopProfile::formatHistogram( int phase, char *buffer, int size ) const
+{
+    int len = snprintf( buffer, size, "[" );
+
+    for (int b=0; b<PROFILE_HIST_BUCKETS && len < size; b++) {
+        len += snprintf( buffer + len, size - len, "%s%u", b ? "," : "", _hist[ phase ][ b ] );
+    }
+
+    if (len < size) len += snprintf( buffer + len, size - len, "]" );
+    return( len );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::formatDetail
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxLoopProfile::formatDetail( char *buffer, int size ) const
+{
+    int len = snprintf( buffer, size, "{" );
+
+    for (int p=0; p<PHASE_COUNT && len < size; p++) {
+
+        len += snprintf( buffer + len, size - len, "%s\"%s\":{\"us\":[%lu,%lu,%lu],\"hist\":",
+                         p ? "," : "", phaseName( p ),
+                         (unsigned long) minUs( p ), (unsigned long) avgUs( p ), (unsigned long) maxUs( p ) );
+
+        if (len < size) len += formatHistogram( p, buffer + len, size - len );
+        if (len < size) len += snprintf( buffer + len, size - len, "}" );
+    }
+
+    if (len < size) len += snprintf( buffer + len, size - len, "}" );
+    return( len );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxLoopProfile::phaseName
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+const char *
+CxLoopProfile::phaseName( int phase )
+{
+    return( _phaseNames[ phase ] );
+}
@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxloopprofile.h
+//
+//  CxLoopProfile Class
+//
+//  Times the phases of loop() with the cpu cycle counter (System.ticks()) and keeps min, average and
+//  max per phase along with a small histogram.  Recording a sample is a handful of integer operations,
+//  formatting only happens when the numbers are asked for.
+//
+//  Comment out USE_LOOP_PROFILE below and the PROFILE_START / PROFILE_STOP macros compile to nothing.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#define USE_LOOP_PROFILE TRUE
+
+#include <Particle.h>
+
+#ifndef _CxLoopProfile_h_
+#define _CxLoopProfile_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+// the phases of loop() that are timed, PHASE_LOOP covers the whole pass less the closing delay
+
+#define PHASE_LOOP       0
+#define PHASE_SCAN       1
+#define PHASE_RELAY      2
+#define PHASE_TIMERS     3
+#define PHASE_PUBLISH    4
+#define PHASE_LED        5
+#define PHASE_COUNT      6
+
+// histogram buckets are powers of four microseconds: <16, <64, <256, <1k, <4k, <16k, <64k, more
+
+#define PROFILE_HIST_BUCKETS 8
+
+#ifdef USE_LOOP_PROFILE
+#define PROFILE_START( profile, phase )  uint32_t _profileStart##phase = (profile).start()
+#define PROFILE_STOP( profile, phase )   (profile).record( phase, _profileStart##phase )
+#else
+#define PROFILE_START( profile, phase )
+#define PROFILE_STOP( profile, phase )
+#endif
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxLoopProfile
+//
+//------------------------------------------------------------------------------------------------------------
+class CxLoopProfile
+{
+  public:
+
+    CxLoopProfile( void );
+    // constructor
+
+    uint32_t start( void ) const;
+    // return the cycle counter, the start stamp for record()
+
+    void record( int phase, uint32_t startTicks );
+    // add the time since startTicks to a phase
+
+    void reset( void );
+    // clear all the phases
+
+    uint32_t minUs( int phase ) const;
+    uint32_t avgUs( int phase ) const;
+    uint32_t maxUs( int phase ) const;
+    // phase timings in microseconds since the last reset
+
+    int formatSummary( char *buffer, int size ) const;
+    // [[min,avg,max],...] for each phase in PHASE_ order, positional to keep the heartbeat small
+
+    int formatHistogram( int phase, char *buffer, int size ) const;
+    // [b0,b1,...,b7]
+
+    int formatDetail( char *buffer, int size ) const;
+    // summary and histogram for every phase
+
+    static const char *phaseName( int phase );
+    // short name of a phase used in the json
+
+  private:
+
+    uint32_t _min[ PHASE_COUNT ];
+    uint32_t _max[ PHASE_COUNT ];
+    uint32_t _sum[ PHASE_COUNT ];
+    uint32_t _count[ PHASE_COUNT ];
+    uint16_t _hist[ PHASE_COUNT ][ PROFILE_HIST_BUCKETS ];
+};
+
+
+#endif
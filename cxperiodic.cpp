@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxperiodic.cpp
+//
+//  CxPeriodic Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxperiodic.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::CxPeriodic
+//
+//------------------------------------------------------------------------------------------------------------
+CxPeriodic::CxPeriodic( void )
+: _interval( 0 ),
+  _jitter( 0 ),
+  _stepStart( 0 ),
+  _deadline( 0 ),
+  _lastFired( 0 ),
+  _lastInterval( 0 ),
+  _skipped( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::begin
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxPeriodic::begin( unsigned long nowMillis, unsigned long intervalMillis, unsigned long jitterMillis )
+{
+    _skipped      = 0;
+    _lastInterval = 0;
+
+    setInterval( nowMillis, intervalMillis, jitterMillis );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::setInterval
+//
+// The jitter has to leave room inside the step or deadlines could land out of order, so it is
+// held below the interval.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxPeriodic::setInterval( unsigned long nowMillis, unsigned long intervalMillis, unsigned long jitterMillis )
+{
+    if (intervalMillis == 0) intervalMillis = 1;
+    if (jitterMillis >= intervalMillis) jitterMillis = intervalMillis - 1;
+
+    _interval  = intervalMillis;
+    _jitter    = jitterMillis;
+    _lastFired = nowMillis;
+    _stepStart = nowMillis + _interval;
+
+    schedule();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::due
+//
+// All the arithmetic is on unsigned differences so the 49 day millis() rollover doesn't matter.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxPeriodic::due( unsigned long nowMillis )
+{
+    if ((long)(nowMillis - _deadline) < 0) return( FALSE );
+
+    _lastInterval = nowMillis - _lastFired;
+    _lastFired    = nowMillis;
+
+    // move to the next step, counting any whole steps that went by without us
+
+    _stepStart += _interval;
+
+    if ((long)(nowMillis - _stepStart) >= 0) {
+        unsigned long behind = (nowMillis - _stepStart) / _interval + 1;
+        _skipped   += behind;
+        _stepStart += behind * _interval;
+    }
+
+    schedule();
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::interval
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPeriodic::interval( void ) const
+{
+    return( _interval );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::jitter
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPeriodic::jitter( void ) const
+{
+    return( _jitter );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::lastInterval
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPeriodic::lastInterval( void ) const
+{
+    return( _lastInterval );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::skipped
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPeriodic::skipped( void ) const
+{
+    return( _skipped );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPeriodic::schedule
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxPeriodic::schedule( void )
+{
+    _deadline = _stepStart;
+
+    if (_jitter) {
+        _deadline += (unsigned long) random( _jitter + 1 );
+    }
+}
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxperiodic.h
+//
+//  CxPeriodic Class
+//
+//  Schedules a recurring report against millis() instead of counting passes through loop(), so the
+//  interval doesn't move when the work done per pass changes.  Deadlines are laid on a fixed grid of
+//  interval steps from begin() and each firing is pushed a random amount into its step by the
+//  jitter, so many devices don't report in step with each other and the jitter never accumulates.
+//  A deadline that passes without due() being called counts as skipped, the schedule then moves to
+//  the next step in the future rather than firing to catch up.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxPeriodic_h_
+#define _CxPeriodic_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxPeriodic
+//
+//------------------------------------------------------------------------------------------------------------
+class CxPeriodic
+{
+  public:
+
+    CxPeriodic( void );
+    // constructor
+
+    void begin( unsigned long nowMillis, unsigned long intervalMillis, unsigned long jitterMillis = 0 );
+    // start the schedule, the first firing is one interval (plus jitter) from now
+
+    void setInterval( unsigned long nowMillis, unsigned long intervalMillis, unsigned long jitterMillis );
+    // change the interval and jitter, the schedule restarts from now
+
+    int due( unsigned long nowMillis );
+    // TRUE once per deadline, when it has been reached.  Also works out the next deadline
+
+    unsigned long interval( void ) const;
+    unsigned long jitter( void ) const;
+
+    unsigned long lastInterval( void ) const;
+    // milliseconds between the last two firings, or since begin() for the first
+
+    unsigned long skipped( void ) const;
+    // deadlines that passed entirely without a firing since begin()
+
+  private:
+
+    void schedule( void );
+    // pick the jittered deadline inside the current step
+
+    unsigned long _interval;
+    unsigned long _jitter;
+    unsigned long _stepStart;               // start of the grid step the next deadline falls in
+    unsigned long _deadline;
+    unsigned long _lastFired;
+    unsigned long _lastInterval;
+    unsigned long _skipped;
+};
+
+
+#endif
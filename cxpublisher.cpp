@@ -0,0 +1,292 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxpublisher.cpp
+//
+//  CxPublisher Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxpublisher.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::CxPublisher
+//
+//------------------------------------------------------------------------------------------------------------
+CxPublisher::CxPublisher( void )
+: _queue( NULL ),
+  _thread( NULL ),
+  _enqueued( 0 ),
+  _taken( 0 ),
+  _published( 0 ),
+  _dropped( 0 ),
+  _failed( 0 ),
+  _outcomesPut( 0 ),
+  _outcomesTaken( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::begin
+//
+// The queue storage and the thread are allocated once here and live for the life of the device.  If
+// the queue can't be had there is no point starting the thread, enqueue() sees the NULL queue and
+// drops everything.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxPublisher::begin( void )
+{
+    if (_thread != NULL) return( TRUE );
+
+    if (os_queue_create( &_queue, sizeof( Item ), PUBLISH_QUEUE_DEPTH, NULL ) != 0) {
+        _queue = NULL;
+        return( FALSE );
+    }
+
+    _thread = new Thread( "publisher", CxPublisher::threadMain, this,
+                          OS_THREAD_PRIORITY_DEFAULT, PUBLISH_THREAD_STACK );
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::enqueue
+//
+// Copies the event into the queue with a zero timeout so the caller can never be held up by the
+// cloud.  Must only be called from the application thread.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxPublisher::enqueue( const char *name, const char *data, unsigned long sequence, unsigned long firstSequence )
+{
+    if ((_queue == NULL) ||
+        (strlen( name ) > PUBLISH_NAME_MAX) ||
+        (strlen( data ) > PUBLISH_DATA_MAX)) {
+        _dropped++;
+        return( FALSE );
+    }
+
+    _outgoing.firstSequence = firstSequence ? firstSequence : sequence;
+    _outgoing.sequence      = sequence;
+    strcpy( _outgoing.name, name );
+    strcpy( _outgoing.data, data );
+
+    if (os_queue_put( _queue, &_outgoing, 0, NULL ) != 0) {
+        _dropped++;
+        return( FALSE );
+    }
+
+    _enqueued++;
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::depth
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxPublisher::depth( void ) const
+{
+    return( (int)(_enqueued - _taken) );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::published
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPublisher::published( void ) const
+{
+    return( _published );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::dropped
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPublisher::dropped( void ) const
+{
+    return( _dropped );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::failed
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxPublisher::failed( void ) const
+{
+    return( _failed );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::nextOutcome
+//
+// The outcome ring has one writer on each side, the entry is copied out before _outcomesTaken moves
+// so the publisher thread can't reuse it underneath us.  volatile only orders the compiler, the 
+// barriers keep the entry and the counters in order for the other thread as well.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxPublisher::nextOutcome( unsigned long *firstSequence, unsigned long *sequence, int *published )
+{
+    if (_outcomesTaken == _outcomesPut) return( FALSE );
+
+    // the entry is read only after the count that says it is there
+
+    __DMB();
+
+    Outcome *outcome = &_outcomes[ _outcomesTaken % PUBLISH_OUTCOME_DEPTH ];
+
+    *firstSequence = outcome->firstSequence;
+    *sequence      = outcome->sequence;
+    *published     = outcome->published;
+
+    // and is finished with before the publisher is told it can have it back
+
+    __DMB();
+
+    _outcomesTaken++;
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::threadMain
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxPublisher::threadMain( void *arg )
+{
+    ((CxPublisher *) arg)->run();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::run
+//
+// Blocks on the queue, then holds each event until the cloud is connected and the rate limit allows
+// it.  A failed publish is retried with a doubling backoff.  All the waiting happens here on the
+// publisher thread, delay() yields to the other threads while it waits.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxPublisher::run( void )
+{
+    unsigned long lastPublish = millis() - PUBLISH_MIN_INTERVAL_MS;
+
+    while (TRUE) {
+
+        if (os_queue_take( _queue, &_current, CONCURRENT_WAIT_FOREVER, NULL ) != 0) {
+            continue;
+        }
+        _taken++;
+
+        unsigned long backoff   = PUBLISH_RETRY_MS;
+        int           attempts  = 0;
+        int           published = FALSE;
+
+        while (TRUE) {
+
+            // waiting for a connection doesn't count as an attempt
+
+            if (!Particle.connected()) {
+                delay( 100 );
+                continue;
+            }
+
+            unsigned long sinceLast = millis() - lastPublish;
+            if (sinceLast < PUBLISH_MIN_INTERVAL_MS) {
+                delay( PUBLISH_MIN_INTERVAL_MS - sinceLast );
+            }
+
+            lastPublish = millis();
+            attempts++;
+
+            if (Particle.publish( _current.name, _current.data )) {
+                _published++;
+                published = TRUE;
+                break;
+            }
+
+            if (attempts >= PUBLISH_MAX_ATTEMPTS) {
+                _failed++;
+                break;
+            }
+
+            delay( backoff );
+
+            backoff *= 2;
+            if (backoff > PUBLISH_RETRY_MAX_MS) backoff = PUBLISH_RETRY_MAX_MS;
+        }
+
+        if (_current.sequence) {
+            report( published );
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxPublisher::report
+//
+// The ring holds one more outcome than the queue holds events, so it only fills if the application 
+// thread stops reading.  The publisher waits for room rather than lose an outcome.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxPublisher::report( int published )
+{
+    while (_outcomesPut - _outcomesTaken >= PUBLISH_OUTCOME_DEPTH) {
+        delay( 10 );
+    }
+
+    // the slot is written only after the application thread has finished reading it
+
+    __DMB();
+
+    Outcome *outcome = &_outcomes[ _outcomesPut % PUBLISH_OUTCOME_DEPTH ];
+
+    outcome->firstSequence = _current.firstSequence;
+    outcome->sequence      = _current.sequence;
+    outcome->published     = published;
+
+    // and is complete before the count that hands it over moves
+
+    __DMB();
+
+    _outcomesPut++;
+}
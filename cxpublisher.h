@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxpublisher.h
+//
+//  CxPublisher Class
+//
+//  Moves Particle.publish off the application thread.  The scan path copies each event into a bounded
+//  queue and returns immediately, a dedicated publisher thread takes events off the queue and does the
+//  cloud work (waiting for a connection, pacing to the cloud rate limit, retrying failures).  If the
+//  queue is full the new event is dropped and counted rather than blocking the scan.
+//
+//  The queue is kept short because every entry is a full sized event, about 660 bytes of heap.  Nothing
+//  is lost when it fills: a sequenced event that doesn't fit stays in the checkpoint backlog and is
+//  queued again as the publisher makes room, so the depth only has to cover the events of a single
+//  scan.  The outcome of every sequenced event, published or abandoned, is handed back to the
+//  application thread one at a time through nextOutcome(), so a caller that keeps its own copy of an
+//  event only lets it go once the cloud really has it.
+//
+//  Requires SYSTEM_THREAD(ENABLED) in the application.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxcheckpoint.h>
+
+#ifndef _CxPublisher_h_
+#define _CxPublisher_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define PUBLISH_QUEUE_DEPTH      8          // events of one busy scan, the backlog covers the rest
+#define PUBLISH_OUTCOME_DEPTH    (PUBLISH_QUEUE_DEPTH + 1)
+#define PUBLISH_NAME_MAX         32         // longest event name
+#define PUBLISH_DATA_MAX         622        // largest payload the cloud accepts
+#define PUBLISH_THREAD_STACK     3072
+#define PUBLISH_MIN_INTERVAL_MS  1000       // cloud allows about one publish a second
+#define PUBLISH_RETRY_MS         1000       // first retry delay, doubles on each failure
+#define PUBLISH_RETRY_MAX_MS     30000
+#define PUBLISH_MAX_ATTEMPTS     6
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxPublisher
+//
+//------------------------------------------------------------------------------------------------------------
+class CxPublisher
+{
+  public:
+
+    CxPublisher( void );
+    // constructor
+
+    int begin( void );
+    // create the queue and start the publisher thread, returns FALSE if the queue couldn't be 
+    // created.  Every event is dropped after that
+
+    int enqueue( const char *name, const char *data, unsigned long sequence = 0, unsigned long firstSequence = 0 );
+    // queue an event without blocking, returns FALSE if it was dropped.  An event with a non zero 
+    // sequence has its outcome reported through nextOutcome(), firstSequence is for an event that
+    // carries a run of sequences ending at sequence
+
+    int depth( void ) const;
+    // events waiting to be published
+
+    unsigned long published( void ) const;
+    // events the cloud accepted
+
+    unsigned long dropped( void ) const;
+    // events lost because the queue was full or the payload too large
+
+    unsigned long failed( void ) const;
+    // events abandoned after PUBLISH_MAX_ATTEMPTS
+
+    int nextOutcome( unsigned long *firstSequence, unsigned long *sequence, int *published );
+    // take the oldest outcome not yet seen, returns FALSE if there is none.  published is FALSE for 
+    // an event abandoned after PUBLISH_MAX_ATTEMPTS.  Must only be called from the application thread
+
+  private:
+
+    struct Item {
+        unsigned long firstSequence;
+        unsigned long sequence;
+        char name[ PUBLISH_NAME_MAX + 1 ];
+        char data[ PUBLISH_DATA_MAX + 1 ];
+    };
+
+    static void threadMain( void *arg );
+    // entry point for the publisher thread
+
+    void run( void );
+    // body of the publisher thread, never returns
+
+    void report( int published );
+    // hand the outcome of the current event back to the application thread
+
+    struct Outcome {
+        unsigned long firstSequence;
+        unsigned long sequence;
+        int           published;
+    };
+
+    os_queue_t _queue;
+    Thread    *_thread;
+    Item       _outgoing;                   // only touched by the application thread
+    Item       _current;                    // only touched by the publisher thread
+    Outcome    _outcomes[ PUBLISH_OUTCOME_DEPTH ];
+
+    // each counter has a single writer so depth can be read without a lock
+
+    volatile unsigned long _enqueued;
+    volatile unsigned long _taken;
+    volatile unsigned long _published;
+    volatile unsigned long _dropped;
+    volatile unsigned long _failed;
+    volatile unsigned long _outcomesPut;    // written by the publisher thread
+    volatile unsigned long _outcomesTaken;  // written by the application thread
+};
+
+
+#endif
@@ -0,0 +1,348 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxschedule.cpp
+//
+//  CxSchedule Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxschedule.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::CxSchedule
+//
+//------------------------------------------------------------------------------------------------------------
+CxSchedule::CxSchedule( void )
+: _ruleCount( 0 ),
+  _transitions( 0 ),
+  _standardOffset( 0 ),
+  _observeDST( FALSE ),
+  _current( 0 ),
+  _nextCheck( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::setTimeZone
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxSchedule::setTimeZone( long standardOffsetSeconds, int observeDST )
+{
+    _standardOffset = standardOffsetSeconds;
+    _observeDST     = observeDST;
+    _nextCheck      = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::addRule
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxSchedule::addRule( uint64_t zoneBits, int days, int startMinute, int endMinute )
+{
+    if (_ruleCount == SCHEDULE_MAX_RULES) return( FALSE );
+
+    Rule *r = &_rules[ _ruleCount++ ];
+    r->zoneBits    = zoneBits;
+    r->days        = days & SCHEDULE_EVERY_DAY;
+    r->startMinute = startMinute % (24 * 60);
+    r->endMinute   = endMinute % (24 * 60);
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::compile
+//
+// Every rule start and end is a candidate transition.  They are insertion sorted (there are only a
+// few dozen, once at load), then each gets the mask of the rules covering it and neighbours with
+// the same mask are merged.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxSchedule::compile( void )
+{
+    uint16_t points[ SCHEDULE_MAX_RULES * 14 ];
+    int      count = 0;
+
+    for (int r=0; r<_ruleCount; r++) {
+        for (int d=0; d<7; d++) {
+
+            if (!(_rules[ r ].days & (1 << d))) continue;
+
+            uint16_t start = d * 24 * 60 + _rules[ r ].startMinute;
+            uint16_t end   = (d * 24 * 60 + _rules[ r ].endMinute +
+                              (_rules[ r ].endMinute <= _rules[ r ].startMinute ? 24 * 60 : 0)) % SCHEDULE_MINUTES_PER_WEEK;
+
+            uint16_t both[2] = { start, end };
+
+            for (int b=0; b<2; b++) {
+                int i = count++;
+                while (i > 0 && points[ i-1 ] > both[ b ]) {
+                    points[ i ] = points[ i-1 ];
+                    i--;
+                }
+                points[ i ] = both[ b ];
+            }
+        }
+    }
+
+    _transitions = 0;
+
+    for (int p=0; p<count; p++) {
+
+        if (p > 0 && points[ p ] == points[ p-1 ]) continue;
+
+        uint64_t mask = covered( points[ p ] );
+        if (_transitions > 0 && _masks[ _transitions-1 ] == mask) continue;
+
+        if (_transitions == SCHEDULE_MAX_TRANSITIONS) {
+            _transitions = 0;
+            return( -1 );
+        }
+
+        _minutes[ _transitions ] = points[ p ];
+        _masks[ _transitions ]   = mask;
+        _transitions++;
+    }
+
+    // the list wraps round the week, a first entry with the same mask as the last isn't a change
+
+    if (_transitions > 1 && _masks[ 0 ] == _masks[ _transitions-1 ]) {
+        for (int t=1; t<_transitions; t++) {
+            _minutes[ t-1 ] = _minutes[ t ];
+            _masks[ t-1 ]   = _masks[ t ];
+        }
+        _transitions--;
+    }
+
+    _nextCheck = 0;
+    return( _transitions );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::due
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxSchedule::due( unsigned long now ) const
+{
+    return( (long)(now - _nextCheck) >= 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::evaluate
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxSchedule::evaluate( unsigned long now )
+{
+    unsigned long nextHour = now - (now % 3600) + 3600;
+
+    if (_transitions == 0) {
+        _current   = 0;
+        _nextCheck = nextHour;
+        return( _current );
+    }
+
+    unsigned long local  = localTime( now );
+    long          days   = (long)(local / 86400);
+    int           minute = (int)((days + 4) % 7) * 24 * 60 + (int)((local % 86400) / 60);
+
+    // last transition at or before minute, the one before the first is the last of the week
+
+    int lo = 0;
+    int hi = _transitions;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (_minutes[ mid ] <= minute) lo = mid + 1; else hi = mid;
+    }
+
+    int index = (lo == 0) ? _transitions - 1 : lo - 1;
+    int next  = (index + 1) % _transitions;
+
+    _current = _masks[ index ];
+
+    long untilNext = ((long) _minutes[ next ] - minute + SCHEDULE_MINUTES_PER_WEEK) % SCHEDULE_MINUTES_PER_WEEK;
+    if (untilNext == 0) untilNext = SCHEDULE_MINUTES_PER_WEEK;
+
+    unsigned long change = now - (local % 60) + untilNext * 60;
+
+    _nextCheck = ((long)(change - nextHour) < 0) ? change : nextHour;
+
+    return( _current );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::current
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxSchedule::current( void ) const
+{
+    return( _current );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::nextCheck
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxSchedule::nextCheck( void ) const
+{
+    return( _nextCheck );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::localTime
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned long
+CxSchedule::localTime( unsigned long now ) const
+{
+    long offset = _standardOffset;
+
+    if (_observeDST && isUSDaylightTime( now, _standardOffset )) {
+        offset += 3600;
+    }
+
+    return( now + offset );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::isUSDaylightTime
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxSchedule::isUSDaylightTime( unsigned long now, long standardOffsetSeconds )
+{
+    long standardDays = (long)((now + standardOffsetSeconds) / 86400);
+    int  year         = yearFromDays( standardDays );
+
+    long march1    = daysFromCivil( year, 3, 1 );
+    long november1 = daysFromCivil( year, 11, 1 );
+
+    // 1970-01-01 was a Thursday, Sunday is (days + 4) % 7 == 0
+
+    long dstStartDay = march1 + (7 - (march1 + 4) % 7) % 7 + 7;
+    long dstEndDay   = november1 + (7 - (november1 + 4) % 7) % 7;
+
+    unsigned long start = dstStartDay * 86400 + 2 * 3600 - standardOffsetSeconds;
+    unsigned long end   = dstEndDay   * 86400 + 1 * 3600 - standardOffsetSeconds;
+
+    return( now >= start && now < end );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::covered
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxSchedule::covered( int minuteOfWeek ) const
+{
+    uint64_t mask = 0;
+
+    int day    = minuteOfWeek / (24 * 60);
+    int minute = minuteOfWeek % (24 * 60);
+
+    for (int r=0; r<_ruleCount; r++) {
+
+        const Rule *rule = &_rules[ r ];
+        int yesterday = (day + 6) % 7;
+
+        if (rule->startMinute < rule->endMinute) {
+
+            if ((rule->days & (1 << day)) && minute >= rule->startMinute && minute < rule->endMinute) {
+                mask |= rule->zoneBits;
+            }
+
+        } else {
+
+            // runs past midnight, started today or is finishing yesterday's
+
+            if (((rule->days & (1 << day)) && minute >= rule->startMinute) ||
+                ((rule->days & (1 << yesterday)) && minute < rule->endMinute)) {
+                mask |= rule->zoneBits;
+            }
+        }
+    }
+
+    return( mask );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::daysFromCivil
+//
+// Days from 1970-01-01 to a proleptic Gregorian date
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+long
+CxSchedule::daysFromCivil( int year, int month, int day )
+{
+    year -= (month <= 2);
+
+    long era = year / 400;
+    long yoe = year - era * 400;
+    long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return( era * 146097 + doe - 719468 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxSchedule::yearFromDays
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxSchedule::yearFromDays( long days )
+{
+    days += 719468;
+
+    long era = days / 146097;
+    long doe = days - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp  = (5 * doy + 2) / 153;
+
+    return( (int)(yoe + era * 400 + (mp >= 10 ? 1 : 0)) );
+}
@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxschedule.h
+//
+//  CxSchedule Class
+//
+//  Weekly schedules for scheduled bypass.  Each rule covers some zones on some days of the week
+//  between two local times; an end before the start runs past midnight into the next day.  compile()
+//  turns the rules into a sorted list of the minutes of the week where the answer changes, each with
+//  the zones covered from then on, so finding the zones covered right now is a binary search.  The
+//  caller only asks when due() says the cached time of the next change has arrived, which costs one
+//  compare per scan.
+//
+//  Times are worked out in local time from a fixed standard offset plus US daylight saving rules.
+//  Rather than trust a change time computed across a daylight saving switch, the cache never looks
+//  past the next hour, so the answer is never more than an hour stale and is normally exact.
+//
+//  Nothing here depends on Particle so the schedule can be checked on the host.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#ifndef _CxSchedule_h_
+#define _CxSchedule_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define SCHEDULE_MAX_RULES        8
+#define SCHEDULE_MAX_TRANSITIONS  64
+#define SCHEDULE_MINUTES_PER_WEEK (7 * 24 * 60)
+
+#define SCHEDULE_SUNDAY     0x01
+#define SCHEDULE_MONDAY     0x02
+#define SCHEDULE_TUESDAY    0x04
+#define SCHEDULE_WEDNESDAY  0x08
+#define SCHEDULE_THURSDAY   0x10
+#define SCHEDULE_FRIDAY     0x20
+#define SCHEDULE_SATURDAY   0x40
+#define SCHEDULE_WEEKDAYS   0x3E
+#define SCHEDULE_EVERY_DAY  0x7F
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxSchedule
+//
+//------------------------------------------------------------------------------------------------------------
+class CxSchedule
+{
+  public:
+
+    CxSchedule( void );
+    // constructor
+
+    void setTimeZone( long standardOffsetSeconds, int observeDST );
+    // offset from UTC outside daylight saving, and whether US daylight saving applies
+
+    int addRule( uint64_t zoneBits, int days, int startMinute, int endMinute );
+    // zones covered on the given SCHEDULE_ days from startMinute to endMinute (minutes after local
+    // midnight).  Returns FALSE when the rule table is full
+
+    int compile( void );
+    // build the transition list, returns the number of transitions or -1 if there are too many
+
+    int due( unsigned long now ) const;
+    // TRUE when evaluate() needs calling, now is seconds from epoch (UTC)
+
+    uint64_t evaluate( unsigned long now );
+    // the zones covered at now, and caches when that next changes
+
+    uint64_t current( void ) const;
+    // result of the last evaluate()
+
+    unsigned long nextCheck( void ) const;
+    // when due() next becomes TRUE
+
+    unsigned long localTime( unsigned long now ) const;
+    // now moved to local time
+
+    static int isUSDaylightTime( unsigned long now, long standardOffsetSeconds );
+    // TRUE from 2am local on the second Sunday in March until 2am local daylight time on the first
+    // Sunday in November
+
+  private:
+
+    struct Rule {
+        uint64_t zoneBits;
+        uint8_t  days;
+        uint16_t startMinute;
+        uint16_t endMinute;
+    };
+
+    uint64_t covered( int minuteOfWeek ) const;
+    // zones any rule covers at a minute of the week
+
+    static long daysFromCivil( int year, int month, int day );
+    static int  yearFromDays( long days );
+
+    Rule          _rules[ SCHEDULE_MAX_RULES ];
+    int           _ruleCount;
+    uint16_t      _minutes[ SCHEDULE_MAX_TRANSITIONS ];     // minute of the week, ascending
+    uint64_t      _masks[ SCHEDULE_MAX_TRANSITIONS ];       // zones covered from that minute on
+    int           _transitions;
+    long          _standardOffset;
+    int           _observeDST;
+    uint64_t      _current;
+    unsigned long _nextCheck;
+};
+
+
+#endif
@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxsnapshot.cpp
+//
+//  CxZoneSnapshot Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cxsnapshot.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::CxZoneSnapshot
+//
+//------------------------------------------------------------------------------------------------------------
+CxZoneSnapshot::CxZoneSnapshot( void )
+: configuredBits( 0 ),
+  activatedBits( 0 ),
+  sequence( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::CxZoneSnapshot
+//
+//------------------------------------------------------------------------------------------------------------
+CxZoneSnapshot::CxZoneSnapshot( uint64_t configuredBits_, uint64_t activatedBits_, unsigned long sequence_ )
+: configuredBits( configuredBits_ ),
+  activatedBits( activatedBits_ ),
+  sequence( sequence_ )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::format
+//
+// The bits are written as two 32 bit halves so the code doesn't lean on printf support for 64 bit
+// integers, which newlib nano on the photon doesn't have.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneSnapshot::format( char *buffer, int size ) const
+{
+    char configured[17];
+    char activated[17];
+
+    formatHex( configuredBits, configured );
+    formatHex( activatedBits, activated );
+
+    return( snprintf( buffer, size, "\"configured\":\"%s\",\"activated\":\"%s\",\"last_seq\":%lu",
+        configured, activated, sequence ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::parse
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneSnapshot::parse( const char *json )
+{
+    uint64_t configured;
+    uint64_t activated;
+
+    if (!findHex( json, "\"configured\":\"", &configured )) return( FALSE );
+    if (!findHex( json, "\"activated\":\"", &activated )) return( FALSE );
+
+    const char *cptr = strstr( json, "\"last_seq\":" );
+    if (cptr == NULL) return( FALSE );
+
+    configuredBits = configured;
+    activatedBits  = activated;
+    sequence       = strtoul( cptr + strlen( "\"last_seq\":" ), NULL, 10 );
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::reconcile
+//
+// Only zones whose effective state (configured and open) differs get an action, so an identical pair
+// of snapshots costs one compare.  A zone that dropped out of the configuration while open is
+// recovered so its incident doesn't stay open forever.  Sequences are 32 bits on the wire whatever
+// the width of unsigned long, so the age check wraps at 32 bits.
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxZoneSnapshot::reconcile( const CxZoneSnapshot& known, const CxZoneSnapshot& current,
+                           CxSnapshotActionHandler handler, void *arg )
+{
+    if ((int32_t)(uint32_t)(current.sequence - known.sequence) < 0) return( -1 );
+
+    uint64_t knownOpen   = known.activatedBits   & known.configuredBits;
+    uint64_t currentOpen = current.activatedBits & current.configuredBits;
+    uint64_t differs     = knownOpen ^ currentOpen;
+
+    int actions = 0;
+
+    while (differs) {
+
+        int channel = __builtin_ctzll( differs );
+        differs &= differs - 1;
+
+        int action = ((currentOpen >> channel) & 1) ? SNAPSHOT_ACTION_CRITICAL : SNAPSHOT_ACTION_RECOVERY;
+
+        if (handler) handler( channel, action, arg );
+        actions++;
+    }
+
+    return( actions );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::formatHex
+//
+// Lower case hex without leading zeros, at most 16 digits plus the terminator
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+void
+CxZoneSnapshot::formatHex( uint64_t value, char *text )
+{
+    unsigned long high = (unsigned long)(value >> 32);
+    unsigned long low  = (unsigned long)(value & 0xFFFFFFFF);
+
+    if (high) {
+        sprintf( text, "%lx%08lx", high, low );
+    } else {
+        sprintf( text, "%lx", low );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneSnapshot::findHex
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxZoneSnapshot::findHex( const char *json, const char *key, uint64_t *value )
+{
+    const char *cptr = strstr( json, key );
+    if (cptr == NULL) return( FALSE );
+
+    cptr += strlen( key );
+
+    uint64_t result = 0;
+    int digits = 0;
+
+    while (*cptr && *cptr != '"') {
+
+        int nibble;
+        if      (*cptr >= '0' && *cptr <= '9') nibble = *cptr - '0';
+        else if (*cptr >= 'a' && *cptr <= 'f') nibble = *cptr - 'a' + 10;
+        else if (*cptr >= 'A' && *cptr <= 'F') nibble = *cptr - 'A' + 10;
+        else return( FALSE );
+
+        result = (result << 4) | nibble;
+        digits++;
+        cptr++;
+    }
+
+    if (digits == 0 || digits > 16) return( FALSE );
+
+    *value = result;
+    return( TRUE );
+}
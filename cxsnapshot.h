@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxsnapshot.h
+//
+//  CxZoneSnapshot Class
+//
+//  The complete zone state in a few bytes: the packed configured and activated bits and the sequence
+//  number of the last transition event.  The heartbeat and the on demand snapshot event carry one of
+//  these so a receiver that lost a transition can find out by comparing snapshots instead of waiting
+//  for the next change.  reconcile() turns a stale and a current snapshot into the smallest set of
+//  CRITICAL / RECOVERY actions that brings the receiver back in line.
+//
+//  Nothing here depends on Particle so the same code can run on the receiving side.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#ifndef _CxZoneSnapshot_h_
+#define _CxZoneSnapshot_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define SNAPSHOT_ACTION_CRITICAL  1         // the zone is open and the receiver thinks it isn't
+#define SNAPSHOT_ACTION_RECOVERY  2         // the zone is closed (or no longer used) and the receiver thinks it is open
+
+typedef void (*CxSnapshotActionHandler)( int channel, int action, void *arg );
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxZoneSnapshot
+//
+//------------------------------------------------------------------------------------------------------------
+class CxZoneSnapshot
+{
+  public:
+
+    CxZoneSnapshot( void );
+    // constructor
+
+    CxZoneSnapshot( uint64_t configuredBits_, uint64_t activatedBits_, unsigned long sequence_ );
+    // constructor with data
+
+    int format( char *buffer, int size ) const;
+    // json fields "configured":"<hex>","activated":"<hex>","last_seq":<n> without the braces
+
+    int parse( const char *json );
+    // pick the snapshot fields out of a heartbeat or snapshot payload, returns FALSE if missing
+
+    static int reconcile( const CxZoneSnapshot& known, const CxZoneSnapshot& current,
+                          CxSnapshotActionHandler handler, void *arg );
+    // call handler for each zone whose open / closed state differs between the snapshots.  Returns
+    // the number of actions, or -1 if current is older than known
+
+    static void formatHex( uint64_t value, char *text );
+    // lower case hex without leading zeros, text needs room for 17 characters
+
+    uint64_t      configuredBits;
+    uint64_t      activatedBits;
+    unsigned long sequence;
+
+  private:
+
+    static int findHex( const char *json, const char *key, uint64_t *value );
+};
+
+
+#endif
@@ -28,6 +28,7 @@
 //
 //------------------------------------------------------------------------------------------------------------
 
+#include <stdint.h>
 #include <string.h>
 #include <cxstring.h>
 
@@ -404,29 +405,6 @@ CxString::stripTrailing( const char *charSet_ )
 }
 
 
-//------------------------------------------------------------------------------------------------------------
-// CxString::nextToken
-//
-//------------------------------------------------------------------------------------------------------------
-CxString
-CxString::nextToken( const char *charSet_ )
-{
-	stripLeading( charSet_ );
-
-	int pos = firstChar( charSet_ );
-
-	if (pos == -1) {
-		pos = length();
-	}
-
-	CxString s = subString( 0, pos );
-
-	remove( 0, pos );
-
-	return( s );
-}
-
-
 //------------------------------------------------------------------------------------------------------------
 // CxString::substring
 //
@@ -581,18 +559,35 @@ CxString::toLower( CxString s )
 unsigned int
 CxString::hashValue( void ) const
 {
-	unsigned int i = 0;
+	return( hashValue( _data ) );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxString::hashValue
+//
+// 32 bit FNV-1a.  Every byte is folded in with an xor and a multiply by the FNV prime, so unlike a
+// plain sum the order of the characters matters (K_NL_W and K_LN_W no longer collide) and short 
+// ids that differ in one character spread across the whole word.
+//
+//------------------------------------------------------------------------------------------------------------
+unsigned int
+CxString::hashValue( const char *cptr, int len )
+{
+	uint32_t h = 2166136261UL;
 
-	char *ptr = &_data[0];
+	if (cptr == NULL) return( h );
 
-	while (*ptr != (char) NULL) {
+	while (len != 0 && *cptr != (char) NULL) {
 
-		i += (unsigned int) *ptr;
+		h ^= (uint8_t) *cptr;
+		h *= 16777619UL;
 
-		ptr++;
+		cptr++;
+		if (len > 0) len--;
 	}
 
-	return( i );
+	return( h );
 }
 
 
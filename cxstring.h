@@ -117,9 +117,6 @@ class CxString
 	CxString& stripTrailing( const char* charSet_ );
 	// strip all the trailing characters contained in charSet
 
-	CxString  nextToken( const char* charSet_ ); 
-	// return the next token as delimited by charSet, removing from self
-
 	CxString  subString( int start, int len );
 	// return a copy of the substring between start and start+len
 
@@ -144,6 +141,9 @@ class CxString
 	unsigned int hashValue( void ) const;
 	// return a integer hash value of self
 
+	static unsigned int hashValue( const char *cptr, int len=-1 );
+	// hash of a c string, or of its first len characters
+
 	static CxString urlDecode( CxString s_ );
 	// return a decoded string	
 
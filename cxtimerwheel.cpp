@@ -0,0 +1,334 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtimerwheel.cpp
+//
+//  CxTimerWheel Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxtimerwheel.h>
+
+#define NIL 0xFFFF
+
+#define L1_BASE  TIMER_WHEEL_L0_SLOTS
+#define L2_BASE  (TIMER_WHEEL_L0_SLOTS + TIMER_WHEEL_LN_SLOTS)
+#define LN_MASK  (TIMER_WHEEL_LN_SLOTS - 1)
+#define L0_MASK  (TIMER_WHEEL_L0_SLOTS - 1)
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::CxTimerWheel
+//
+//------------------------------------------------------------------------------------------------------------
+CxTimerWheel::CxTimerWheel( void )
+{
+    for (int c=0; c<TIMER_WHEEL_TOTAL_SLOTS; c++) {
+        _slots[c] = NIL;
+    }
+
+    // chain every node onto the free list, generation starts at one so a handle is never zero
+
+    for (int c=0; c<TIMER_WHEEL_CAPACITY; c++) {
+        _nodes[c].next       = (c == TIMER_WHEEL_CAPACITY-1) ? NIL : c+1;
+        _nodes[c].prev       = NIL;
+        _nodes[c].slot       = NIL;
+        _nodes[c].generation = 1;
+        _nodes[c].expires    = 0;
+        _nodes[c].callback   = NULL;
+        _nodes[c].arg        = NULL;
+    }
+
+    _freeList    = 0;
+    _currentTick = 0;
+    _lastMillis  = 0;
+    _entries     = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::begin
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxTimerWheel::begin( unsigned long nowMillis )
+{
+    _lastMillis = nowMillis;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::start
+//
+// Takes a node from the free list and files it.  The handle carries the node's generation in the top
+// half so a handle kept after its timer fired can never cancel whoever reuses the node.
+//
+//------------------------------------------------------------------------------------------------------------
+CxTimerHandle
+CxTimerWheel::start( unsigned long delayMillis, CxTimerCallback callback, void *arg )
+{
+    if (_freeList == NIL) return( TIMER_HANDLE_NONE );
+
+    uint16_t index = _freeList;
+    Node *n = &_nodes[ index ];
+    _freeList = n->next;
+
+    // round up, plus a tick for the part of the current tick that has already gone, so a timer
+    // never fires early
+
+    unsigned long ticks = (delayMillis + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS + 1;
+
+    n->expires  = _currentTick + (uint32_t) ticks;
+    n->callback = callback;
+    n->arg      = arg;
+
+    file( index );
+    _entries++;
+
+    return( ((CxTimerHandle) n->generation << 16) | index );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::cancel
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTimerWheel::cancel( CxTimerHandle handle )
+{
+    int index = lookup( handle );
+    if (index < 0) return( FALSE );
+
+    unlink( index );
+
+    Node *n = &_nodes[ index ];
+    n->generation++;
+    if (n->generation == 0) n->generation = 1;
+    n->next   = _freeList;
+    _freeList = index;
+    _entries--;
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::pending
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTimerWheel::pending( CxTimerHandle handle ) const
+{
+    if (lookup( handle ) < 0) return( FALSE );
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::advance
+//
+// Steps the wheel one tick at a time up to nowMillis.  The elapsed time is taken as an unsigned
+// difference so the 49 day millis() rollover is invisible to the wheel.  Callbacks run from here and
+// may freely start or cancel timers, including other timers due in the same slot.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTimerWheel::advance( unsigned long nowMillis )
+{
+    int fired = 0;
+
+    unsigned long ticks = (nowMillis - _lastMillis) / TIMER_WHEEL_TICK_MS;
+    _lastMillis += ticks * TIMER_WHEEL_TICK_MS;
+
+    while (ticks--) {
+
+        _currentTick++;
+
+        int index0 = _currentTick & L0_MASK;
+
+        if (index0 == 0) {
+
+            int index1 = (_currentTick >> TIMER_WHEEL_L0_BITS) & LN_MASK;
+
+            if (index1 == 0) {
+                cascade( 2, (_currentTick >> (TIMER_WHEEL_L0_BITS + TIMER_WHEEL_LN_BITS)) & LN_MASK );
+            }
+
+            cascade( 1, index1 );
+        }
+
+        // pop timers one at a time so a callback canceling a neighbour leaves the slot consistent
+
+        while (_slots[ index0 ] != NIL) {
+
+            uint16_t index = _slots[ index0 ];
+            Node *n = &_nodes[ index ];
+
+            unlink( index );
+
+            // a long timer parked at the top of the wheel may not really be due yet
+
+            if ((int32_t)(n->expires - _currentTick) > 0) {
+                file( index );
+                continue;
+            }
+
+            CxTimerCallback callback = n->callback;
+            void *arg = n->arg;
+
+            n->generation++;
+            if (n->generation == 0) n->generation = 1;
+            n->next   = _freeList;
+            _freeList = index;
+            _entries--;
+
+            if (callback) callback( arg );
+            fired++;
+        }
+    }
+
+    return( fired );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::entries
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTimerWheel::entries( void ) const
+{
+    return( _entries );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::file
+//
+// Chooses the level from the distance to expiry and the slot from the expiry tick itself, so a
+// node filed in a higher level is picked up when the wheel enters its block and moved down.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxTimerWheel::file( uint16_t index )
+{
+    Node *n = &_nodes[ index ];
+
+    int32_t  delta   = (int32_t)(n->expires - _currentTick);
+    uint32_t expires = n->expires;
+    uint16_t slot;
+
+    if (delta <= 0) {
+        expires = _currentTick + 1;
+        delta   = 1;
+    }
+
+    if ((uint32_t) delta > TIMER_WHEEL_MAX_TICKS) {
+        expires = _currentTick + TIMER_WHEEL_MAX_TICKS;
+        delta   = TIMER_WHEEL_MAX_TICKS;
+    }
+
+    if (delta < TIMER_WHEEL_L0_SLOTS) {
+        slot = expires & L0_MASK;
+    } else if (delta < (1L << (TIMER_WHEEL_L0_BITS + TIMER_WHEEL_LN_BITS))) {
+        slot = L1_BASE + ((expires >> TIMER_WHEEL_L0_BITS) & LN_MASK);
+    } else {
+        slot = L2_BASE + ((expires >> (TIMER_WHEEL_L0_BITS + TIMER_WHEEL_LN_BITS)) & LN_MASK);
+    }
+
+    n->slot = slot;
+    n->prev = NIL;
+    n->next = _slots[ slot ];
+
+    if (n->next != NIL) {
+        _nodes[ n->next ].prev = index;
+    }
+
+    _slots[ slot ] = index;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::unlink
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxTimerWheel::unlink( uint16_t index )
+{
+    Node *n = &_nodes[ index ];
+
+    if (n->prev != NIL) {
+        _nodes[ n->prev ].next = n->next;
+    } else {
+        _slots[ n->slot ] = n->next;
+    }
+
+    if (n->next != NIL) {
+        _nodes[ n->next ].prev = n->prev;
+    }
+
+    n->next = NIL;
+    n->prev = NIL;
+    n->slot = NIL;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::cascade
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxTimerWheel::cascade( int level, int slot )
+{
+    uint16_t base = (level == 1) ? L1_BASE : L2_BASE;
+
+    // detach the whole slot first, re-filing can never land a node back in the slot being emptied
+
+    uint16_t index = _slots[ base + slot ];
+    _slots[ base + slot ] = NIL;
+
+    while (index != NIL) {
+        uint16_t next = _nodes[ index ].next;
+        file( index );
+        index = next;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTimerWheel::lookup
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTimerWheel::lookup( CxTimerHandle handle ) const
+{
+    uint16_t index      = handle & 0xFFFF;
+    uint16_t generation = handle >> 16;
+
+    if (index >= TIMER_WHEEL_CAPACITY) return( -1 );
+    if (_nodes[ index ].generation != generation) return( -1 );
+    if (_nodes[ index ].slot == NIL) return( -1 );
+
+    return( index );
+}
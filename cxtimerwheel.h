@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtimerwheel.h
+//
+//  CxTimerWheel Class
+//
+//  A hierarchical timer wheel keyed on millis().  Timers are kept in a fixed pool so starting and
+//  canceling a timer never touches the heap.  Start and cancel are O(1), expiry is amortized O(1) per
+//  timer (a timer is moved down at most once per level before it fires).
+//
+//  The wheel has three levels.  Level 0 has 256 slots of one tick each, levels 1 and 2 have 64 slots
+//  that each cover a whole revolution of the level below.  With a 10ms tick the wheel spans about
+//  2.9 hours, timers asked to run longer than that are parked in the top level and re-filed until
+//  they reach their real deadline.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxTimerWheel_h_
+#define _CxTimerWheel_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define TIMER_WHEEL_TICK_MS      10         // resolution of the wheel
+
+// most timers that can be running at once.  Each costs a 20 byte node on the Photon, a build with more
+// zones or per zone timers can raise it with -DTIMER_WHEEL_CAPACITY up to the 16 bit node index limit
+#ifndef TIMER_WHEEL_CAPACITY
+#define TIMER_WHEEL_CAPACITY     256
+#endif
+
+#if (TIMER_WHEEL_CAPACITY < 1) || (TIMER_WHEEL_CAPACITY > 0xFFFF)
+#error "TIMER_WHEEL_CAPACITY must be between 1 and 65535"
+#endif
+
+#define TIMER_WHEEL_L0_BITS      8
+#define TIMER_WHEEL_LN_BITS      6
+#define TIMER_WHEEL_L0_SLOTS     (1 << TIMER_WHEEL_L0_BITS)
+#define TIMER_WHEEL_LN_SLOTS     (1 << TIMER_WHEEL_LN_BITS)
+#define TIMER_WHEEL_TOTAL_SLOTS  (TIMER_WHEEL_L0_SLOTS + 2 * TIMER_WHEEL_LN_SLOTS)
+#define TIMER_WHEEL_MAX_TICKS    ((1UL << (TIMER_WHEEL_L0_BITS + 2 * TIMER_WHEEL_LN_BITS)) - 1)
+
+#define TIMER_HANDLE_NONE        0
+
+typedef void (*CxTimerCallback)( void *arg );
+typedef uint32_t CxTimerHandle;
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxTimerWheel
+//
+//------------------------------------------------------------------------------------------------------------
+class CxTimerWheel
+{
+  public:
+
+    CxTimerWheel( void );
+    // constructor
+
+    void begin( unsigned long nowMillis );
+    // set the wheel's notion of now, call once before starting timers
+
+    CxTimerHandle start( unsigned long delayMillis, CxTimerCallback callback, void *arg );
+    // start a one shot timer, returns TIMER_HANDLE_NONE if the pool is exhausted
+
+    int cancel( CxTimerHandle handle );
+    // cancel a running timer, returns TRUE if the timer was still pending
+
+    int pending( CxTimerHandle handle ) const;
+    // returns TRUE if the timer has neither fired nor been canceled
+
+    int advance( unsigned long nowMillis );
+    // run every timer that has come due, returns the number fired
+
+    int entries( void ) const;
+    // number of timers currently running
+
+  private:
+
+    struct Node {
+        uint16_t        next;
+        uint16_t        prev;
+        uint16_t        slot;
+        uint16_t        generation;
+        uint32_t        expires;            // tick the timer is due on
+        CxTimerCallback callback;
+        void           *arg;
+    };
+
+    void file( uint16_t index );
+    // place a node in the slot matching its expiry
+
+    void unlink( uint16_t index );
+    // remove a node from whatever slot holds it
+
+    void cascade( int level, int slot );
+    // re-file every node in a higher level slot
+
+    int lookup( CxTimerHandle handle ) const;
+    // return the node index for a handle, or -1 if stale
+
+    Node          _nodes[ TIMER_WHEEL_CAPACITY ];
+    uint16_t      _slots[ TIMER_WHEEL_TOTAL_SLOTS ];
+    uint16_t      _freeList;
+    uint32_t      _currentTick;
+    unsigned long _lastMillis;
+    int           _entries;
+};
+
+
+#endif
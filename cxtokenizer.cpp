@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtokenizer.cpp
+//
+//  CxToken and CxTokenizer Classes
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+// 
+// Copyright (c) 2017 Todd Vernon
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <ctype.h>
+#include <limits.h>
+#include <string.h>
+#include <cxtokenizer.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::CxToken
+//
+//------------------------------------------------------------------------------------------------------------
+CxToken::CxToken( void )
+: _data( "" ), _length( 0 )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::data
+//
+//------------------------------------------------------------------------------------------------------------
+const char *
+CxToken::data( void ) const
+{
+    return( _data );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::length
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxToken::length( void ) const
+{
+    return( _length );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::isNull
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxToken::isNull( void ) const
+{
+    return( _length == 0 ? TRUE : FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::equals
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxToken::equals( const char *text ) const
+{
+    for (int c=0; c<_length; c++) {
+        if (text[c] == 0) return( FALSE );
+        if (tolower( (unsigned char) _data[c] ) != tolower( (unsigned char) text[c] )) return( FALSE );
+    }
+
+    return( text[ _length ] == 0 ? TRUE : FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxToken::toLong
+//
+// The magnitude is built unsigned and checked against the limit before every digit, so a number too
+// big for a long is refused rather than wrapped round onto a small one.  long is 32 bits on the
+// photon, a channel of 4294967297 would otherwise come out as 1.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxToken::toLong( long *value ) const
+{
+    int           c        = 0;
+    int           negative = FALSE;
+    unsigned long result   = 0;
+
+    if (_length > 0 && _data[0] == '-') {
+        negative = TRUE;
+        c++;
+    }
+
+    if (c == _length) return( FALSE );
+
+    unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+
+    for (; c<_length; c++) {
+        if (_data[c] < '0' || _data[c] > '9') return( FALSE );
+
+        unsigned long digit = _data[c] - '0';
+        if (result > (limit - digit) / 10) return( FALSE );
+
+        result = result * 10 + digit;
+    }
+
+    *value = negative ? (result ? -(long)(result - 1) - 1 : 0) : (long) result;
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTokenizer::CxTokenizer
+//
+//------------------------------------------------------------------------------------------------------------
+CxTokenizer::CxTokenizer( const char *text, const char *delimiters )
+: _cursor( text ? text : "" ), _delimiters( delimiters )
+{
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTokenizer::next
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTokenizer::next( CxToken *token )
+{
+    while (*_cursor && isDelimiter( *_cursor )) _cursor++;
+
+    token->_data   = _cursor;
+    token->_length = 0;
+
+    while (*_cursor && !isDelimiter( *_cursor )) {
+        _cursor++;
+        token->_length++;
+    }
+
+    return( token->_length > 0 ? TRUE : FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTokenizer::rest
+//
+//------------------------------------------------------------------------------------------------------------
+const char *
+CxTokenizer::rest( void )
+{
+    while (*_cursor && isDelimiter( *_cursor )) _cursor++;
+    return( _cursor );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxTokenizer::isDelimiter
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxTokenizer::isDelimiter( char ch ) const
+{
+    return( strchr( _delimiters, ch ) != NULL ? TRUE : FALSE );
+}
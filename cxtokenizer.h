@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtokenizer.h
+//
+//  CxToken and CxTokenizer Classes
+//
+//  Splits a command line into tokens without copying it.  A CxToken is a pointer and a length into
+//  the caller's text, the tokenizer just walks a cursor over it, so parsing a cloud command never
+//  touches the heap.  Everything here is only good for as long as the text it was made from.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+// 
+// Copyright (c) 2017 Todd Vernon
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#ifndef _CxTokenizer_h_
+#define _CxTokenizer_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxToken
+//
+//------------------------------------------------------------------------------------------------------------
+class CxToken
+{
+  public:
+
+    CxToken( void );
+    // constructor, an empty token
+
+    const char *data( void ) const;
+    // first character of the token, not null terminated
+
+    int length( void ) const;
+    // characters in the token
+
+    int isNull( void ) const;
+    // TRUE if the token is empty
+
+    int equals( const char *text ) const;
+    // TRUE if the token matches text, ignoring case
+
+    int toLong( long *value ) const;
+    // parse the whole token as a decimal number, returns FALSE and leaves value alone if it isn't one
+    // or doesn't fit in a long
+
+  private:
+
+    friend class CxTokenizer;
+
+    const char *_data;
+    int         _length;
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxTokenizer
+//
+//------------------------------------------------------------------------------------------------------------
+class CxTokenizer
+{
+  public:
+
+    CxTokenizer( const char *text, const char *delimiters );
+    // constructor, tokens are separated by any run of the delimiter characters
+
+    int next( CxToken *token );
+    // the next token, returns FALSE with an empty token once the text is used up
+
+    const char *rest( void );
+    // whatever is left after the delimiters in front of it, for an argument that may hold delimiters
+
+  private:
+
+    int isDelimiter( char ch ) const;
+
+    const char *_cursor;
+    const char *_delimiters;
+};
+
+
+#endif
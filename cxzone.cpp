@@ -28,6 +28,7 @@
 //
 //------------------------------------------------------------------------------------------------------------
 
+#include <string.h>
 #include <cxstring.h>
 #include <cxzone.h>
     
@@ -57,6 +58,7 @@ CxZone::CxZone( int zoneNumber_,
 		        _description(description_),
 		        _compassLocation( compassLocation_ ),
 		        _sensorType( sensorType_ ),
+		        _type( parseSensorType( sensorType_ )),
 		        _id( id_ ),
 		        _ledBitPosition( ledBitPosition_),
 		        _configured( configured_ ),
@@ -76,6 +78,7 @@ CxZone::CxZone(const CxZone& z)
 		_description = z.description();
 		_compassLocation = z.compassLocation();
 		_sensorType  = z.sensorType();
+		_type        = z.type();
 		_id          = z.id();
 		_ledBitPosition = z.ledBitPosition();
 		_configured  = z.configured();
@@ -97,6 +100,7 @@ CxZone::operator=(const CxZone& z)
 		_description     = z.description();
 		_compassLocation = z.compassLocation();
 		_sensorType      = z.sensorType();
+		_type            = z.type();
 		_id              = z.id();
 		_ledBitPosition  = z.ledBitPosition();
 		_configured      = z.configured();
@@ -107,6 +111,21 @@ CxZone::operator=(const CxZone& z)
 	return(*this);
 }
 
+//------------------------------------------------------------------------------------------------------------
+// CxZone::parseSensorType
+//
+//------------------------------------------------------------------------------------------------------------
+/* static */
+int
+CxZone::parseSensorType( const CxString& sensorType_ )
+{
+    if (sensorType_ == "DOOR")   return( SENSOR_DOOR );
+    if (sensorType_ == "WINDOW") return( SENSOR_WINDOW );
+    if (sensorType_ == "MOTION") return( SENSOR_MOTION );
+    
+    return( SENSOR_UNKNOWN );
+}
+
 //------------------------------------------------------------------------------------------------------------
 // CxZone::setZoneState
 //
@@ -129,6 +148,55 @@ CxZone::setZoneActivated( int activated )
 }
 
 
+//------------------------------------------------------------------------------------------------------------
+// CxZone::restoreActivated
+//
+// Sets the zone state recovered from a checkpoint after a reset.  The zone is not marked as changed
+// so the first scan only reports zones that really moved while the device was down.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZone::restoreActivated( int activated )
+{
+    _activated = activated;
+    _changed   = FALSE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZone::setConfigured
+//
+// Used when a configuration is applied without a reset.  The zone starts closed and unchanged, a 
+// zone coming into use that is really open is picked up as a change by the next scan.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZone::setConfigured( int configured )
+{
+    _configured = configured;
+    _activated  = FALSE;
+    _changed    = FALSE;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZone::setDescription
+//
+// The current name is compared in place so applying an unchanged configuration allocates nothing.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZone::setDescription( const char *text, int len )
+{
+    if ((int) strlen( _description.data() ) == len && strncmp( _description.data(), text, len ) == 0) {
+        return( FALSE );
+    }
+
+    _description = CxString( text, len );
+    return( TRUE );
+}
+
+
 //------------------------------------------------------------------------------------------------------------
 // CxZone::operator==
 //
@@ -170,6 +238,16 @@ CxZone::compassLocation(void) const
 	return(_compassLocation);
 }
 
+//------------------------------------------------------------------------------------------------------------
+// CxZone::type
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZone::type(void) const
+{
+	return(_type);
+}
+
 //------------------------------------------------------------------------------------------------------------
 // CxZone::sensorType
 //
@@ -252,6 +330,22 @@ CxZone::changed(void) const
 //------------------------------------------------------------------------------------------------------------
 CxString
 CxZone::format_victorops_json(void) const
+{
+    return( format_victorops_json( _activated, Time.now() ));
+}
+
+//------------------------------------------------------------------------------------------------------------
+// CxZone::format_victorops_json
+//
+// Same payload for a given state and time, used to resend transitions recovered from a checkpoint.
+// When an event key is given the sequence number and key are added so the receiver can drop 
+// duplicates, a resent transition carries the same key as the original.  The message type is 
+// CRITICAL for open and RECOVERY for closed unless a severity is given.
+//
+//------------------------------------------------------------------------------------------------------------
+CxString
+CxZone::format_victorops_json(int activated, unsigned long eventTime, 
+                             unsigned long sequence, const char *eventKey, const char *severity) const
 {
     CxString openBracket  = "{";
     CxString closeBracket = "}";
@@ -261,7 +355,7 @@ CxZone::format_victorops_json(void) const
     
     char buffer[100];
     
-    sprintf(buffer, "%lu", Time.now() );
+    sprintf(buffer, "%lu", eventTime );
     CxString startTimeString = buffer;
 
     uint32_t freemem = System.freeMemory();
@@ -276,14 +370,18 @@ CxZone::format_victorops_json(void) const
     CxString messageString = _description;
     CxString severityString;
     
-    if (_activated ) {
-        messageString  += " is OPEN";
+    if (activated ) {
+        messageString  += (_type == SENSOR_MOTION) ? " detected MOTION" : " is OPEN";
         severityString  = "CRITICAL";
     } else {
-        messageString  += " is CLOSED";
+        messageString  += (_type == SENSOR_MOTION) ? " is QUIET" : " is CLOSED";
         severityString  = "RECOVERY";
     }
     
+    if (severity != NULL) {
+        severityString = severity;
+    }
+    
     CxString data;
     data += openBracket;
     data += quote + "channel_number" + quote + colon + quote + zoneNumberString + quote;
@@ -299,6 +397,15 @@ CxZone::format_victorops_json(void) const
     data += quote + "state_start_time" + quote + colon + startTimeString.data();
     data += comma;
     data += quote + "free_memory" + quote + colon + freeMemString.data();
+    
+    if (eventKey != NULL) {
+        sprintf(buffer, "%lu", sequence );
+        data += comma;
+        data += quote + "seq" + quote + colon + buffer;
+        data += comma;
+        data += quote + "event_key" + quote + colon + quote + eventKey + quote;
+    }
+    
     data += closeBracket;
     
     return(data);
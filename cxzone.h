@@ -42,6 +42,15 @@
 #define CLOSED_STATE 1
 #define OPEN_STATE   0
 
+// sensor types, parsed from the channel map once at load so per type handling is a table lookup
+enum CxSensorType {
+    SENSOR_UNKNOWN = 0,
+    SENSOR_DOOR,
+    SENSOR_WINDOW,
+    SENSOR_MOTION,
+    SENSOR_TYPES
+};
+
 //------------------------------------------------------------------------------------------------------------
 // CxPropEntry
 //
@@ -78,10 +87,14 @@ class CxZone
 	// comparison operator
 
     int setZoneActivated( int value );      // set the zone state, return true if its different
+    void restoreActivated( int value );     // set the zone state from a checkpoint, not a change
+    void setConfigured( int value );        // put the zone in or out of use, it comes back closed
+    int  setDescription( const char *text, int len );  // rename, return true if the name changed
 	CxString roomName( void ) const;        // Garage
 	CxString description( void ) const;     // Garage Outside Door
 	CxString compassLocation( void ) const; // Where in room sensor is
     CxString sensorType( void ) const;      // DOOR, WINDOW
+    int      type( void ) const;            // SENSOR_DOOR, SENSOR_WINDOW, SENSOR_MOTION
     CxString id( void ) const;              // G_O_D = Garage Outside Door
     int      ledBitPosition( void ) const;  // The led output bit for the channel id
     int      configured( void ) const;      // used in the configuration or not
@@ -89,12 +102,19 @@ class CxZone
     int      zoneNumber( void ) const;      // zone number on unit
     int      changed( void ) const;
     
+    static int parseSensorType( const CxString& sensorType_ );
+    // DOOR, WINDOW or MOTION to a CxSensorType, SENSOR_UNKNOWN for anything else
+
     CxString format_victorops_json(void) const;
+    CxString format_victorops_json(int activated, unsigned long eventTime, 
+                                   unsigned long sequence = 0, const char *eventKey = NULL,
+                                   const char *severity = NULL) const;
 
     CxString _roomName;
     CxString _description;
     CxString _compassLocation;              // N, S, E, W, NL
     CxString _sensorType;
+    int      _type;                         // _sensorType as a CxSensorType
     CxString _id;
     int      _ledBitPosition;
     int      _configured;                   // TRUE == is this zone used in the system
@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzonegroups.cpp
+//
+//  CxZoneGroups Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxzonegroups.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::CxZoneGroups
+//
+//------------------------------------------------------------------------------------------------------------
+CxZoneGroups::CxZoneGroups( void )
+: _groups( 0 )
+{
+    for (int g=0; g<GROUP_MAX; g++) {
+        _names[ g ]      = NULL;
+        _bits[ g ]       = 0;
+        _openCounts[ g ] = 0;
+    }
+
+    for (int c=0; c<GROUP_CHANNELS; c++) {
+        _channelGroups[ c ] = 0;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::add
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::add( const char *name, int channel )
+{
+    if (channel < 0 || channel >= GROUP_CHANNELS) return( GROUP_NONE );
+
+    int group = find( name );
+
+    if (group == GROUP_NONE) {
+        if (_groups == GROUP_MAX) return( GROUP_NONE );
+        group = _groups++;
+        _names[ group ] = name;
+    }
+
+    _bits[ group ]           |= (1ULL << channel);
+    _channelGroups[ channel ] |= (1UL << group);
+
+    return( group );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::remove
+//
+// The group itself stays, with one zone fewer, so group indexes never move.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZoneGroups::remove( int channel )
+{
+    if (channel < 0 || channel >= GROUP_CHANNELS) return;
+
+    uint32_t member = _channelGroups[ channel ];
+
+    while (member) {
+
+        int group = __builtin_ctzl( member );
+        member &= member - 1;
+
+        _bits[ group ] &= ~(1ULL << channel);
+    }
+
+    _channelGroups[ channel ] = 0;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::begin
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZoneGroups::begin( uint64_t activatedBits )
+{
+    for (int g=0; g<_groups; g++) {
+        _openCounts[ g ] = __builtin_popcountll( activatedBits & _bits[ g ] );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::transition
+//
+//------------------------------------------------------------------------------------------------------------
+uint32_t
+CxZoneGroups::transition( int channel, int activated )
+{
+    if (channel < 0 || channel >= GROUP_CHANNELS) return( 0 );
+
+    uint32_t member  = _channelGroups[ channel ];
+    uint32_t changed = 0;
+
+    while (member) {
+
+        int group = __builtin_ctzl( member );
+        member &= member - 1;
+
+        if (activated) {
+            if (_openCounts[ group ]++ == 0) changed |= (1UL << group);
+        } else if (_openCounts[ group ] > 0) {
+            if (--_openCounts[ group ] == 0) changed |= (1UL << group);
+        }
+    }
+
+    return( changed );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::groups
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::groups( void ) const
+{
+    return( _groups );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::find
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::find( const char *name ) const
+{
+    for (int g=0; g<_groups; g++) {
+        if (strcmp( _names[ g ], name ) == 0) return( g );
+    }
+
+    return( GROUP_NONE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::name
+//
+//------------------------------------------------------------------------------------------------------------
+const char *
+CxZoneGroups::name( int group ) const
+{
+    if (group < 0 || group >= _groups) return( "" );
+    return( _names[ group ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::bits
+//
+//------------------------------------------------------------------------------------------------------------
+uint64_t
+CxZoneGroups::bits( int group ) const
+{
+    if (group < 0 || group >= _groups) return( 0 );
+    return( _bits[ group ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::openCount
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::openCount( int group ) const
+{
+    if (group < 0 || group >= _groups) return( 0 );
+    return( _openCounts[ group ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::open
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::open( int group ) const
+{
+    return( openCount( group ) > 0 ? TRUE : FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneGroups::format
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneGroups::format( char *buffer, int size ) const
+{
+    int len = snprintf( buffer, size, "{" );
+
+    for (int g=0; g<_groups && len < size; g++) {
+        len += snprintf( buffer + len, size - len, "%s\"%s\":%d", g ? "," : "", _names[ g ], _openCounts[ g ] );
+    }
+
+    if (len < size) len += snprintf( buffer + len, size - len, "}" );
+    return( len );
+}
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzonegroups.h
+//
+//  CxZoneGroups Class
+//
+//  Named groups of zones, the rooms from the channel map to start with.  Membership is compiled at
+//  load into one 64 bit mask per group and a per channel mask of the groups it belongs to, so
+//  asking whether a group has anything open is a single AND against the zone bits.  Each group also
+//  keeps a count of its open zones that is only touched when one of its zones changes, which is how
+//  the caller finds out a room has just opened or closed without looking at the other zones.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxZoneGroups_h_
+#define _CxZoneGroups_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define USE_ROOM_EVENTS  TRUE         // send an event when a room opens or closes
+
+#define GROUP_MAX        16
+#define GROUP_CHANNELS   48
+#define GROUP_NONE       -1
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxZoneGroups
+//
+//------------------------------------------------------------------------------------------------------------
+class CxZoneGroups
+{
+  public:
+
+    CxZoneGroups( void );
+    // constructor
+
+    int add( const char *name, int channel );
+    // put a channel in the named group, creating it if need be.  The name is not copied and must
+    // stay put.  Returns the group index or GROUP_NONE if the table is full
+
+    void remove( int channel );
+    // take a channel out of every group, the caller settles its open state first
+
+    void begin( uint64_t activatedBits );
+    // set the open counts from the current zone state
+
+    uint32_t transition( int channel, int activated );
+    // a zone changed, returns a mask of the groups that went from closed to open or back
+
+    int groups( void ) const;
+    // number of groups
+
+    int find( const char *name ) const;
+    // group index by name, GROUP_NONE if there isn't one
+
+    const char *name( int group ) const;
+
+    uint64_t bits( int group ) const;
+    // the group's zones, bit n is channel n
+
+    int openCount( int group ) const;
+    // open zones in the group
+
+    int open( int group ) const;
+    // TRUE if any zone in the group is open
+
+    int format( char *buffer, int size ) const;
+    // {"<group>":<open count>,...}
+
+  private:
+
+    const char *_names[ GROUP_MAX ];
+    uint64_t    _bits[ GROUP_MAX ];
+    uint8_t     _openCounts[ GROUP_MAX ];
+    uint32_t    _channelGroups[ GROUP_CHANNELS ];
+    int         _groups;
+};
+
+
+#endif
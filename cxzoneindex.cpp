@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzoneindex.cpp
+//
+//  CxZoneIndex Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxstring.h>
+#include <cxzoneindex.h>
+
+#define SLOT_MASK (ZONE_INDEX_SLOTS - 1)
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::CxZoneIndex
+//
+//------------------------------------------------------------------------------------------------------------
+CxZoneIndex::CxZoneIndex( void )
+: _entries( 0 ), _maxProbe( 0 )
+{
+    for (int s=0; s<ZONE_INDEX_SLOTS; s++) {
+        _slots[ s ].hash    = 0;
+        _slots[ s ].id      = NULL;
+        _slots[ s ].channel = ZONE_INDEX_NONE;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::add
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneIndex::add( const char *id, int channel )
+{
+    if (_entries >= ZONE_INDEX_SLOTS / 2) return( FALSE );
+
+    uint32_t hash = CxString::hashValue( id );
+    int      slot = hash & SLOT_MASK;
+    int      probe;
+
+    for (probe=1; _slots[ slot ].id != NULL; probe++) {
+
+        if (_slots[ slot ].hash == hash && strcmp( _slots[ slot ].id, id ) == 0) return( TRUE );
+        slot = (slot + 1) & SLOT_MASK;
+    }
+
+    _slots[ slot ].hash    = hash;
+    _slots[ slot ].id      = id;
+    _slots[ slot ].channel = channel;
+
+    _entries++;
+    if (probe > _maxProbe) _maxProbe = probe;
+
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::find
+//
+// Linear probing from the home slot, an empty slot ends the search since nothing is ever removed.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneIndex::find( const char *id, int len ) const
+{
+    if (id == NULL) return( ZONE_INDEX_NONE );
+
+    uint32_t hash = CxString::hashValue( id, len );
+    int      slot = hash & SLOT_MASK;
+
+    while (_slots[ slot ].id != NULL) {
+
+        if (_slots[ slot ].hash == hash && matches( _slots[ slot ].id, id, len )) {
+            return( _slots[ slot ].channel );
+        }
+
+        slot = (slot + 1) & SLOT_MASK;
+    }
+
+    return( ZONE_INDEX_NONE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::entries
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneIndex::entries( void ) const
+{
+    return( _entries );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::maxProbe
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneIndex::maxProbe( void ) const
+{
+    return( _maxProbe );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneIndex::matches
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneIndex::matches( const char *id, const char *key, int len )
+{
+    if (len < 0) return( strcmp( id, key ) == 0 ? TRUE : FALSE );
+
+    if (strncmp( id, key, len ) != 0) return( FALSE );
+    return( id[ len ] == 0 ? TRUE : FALSE );
+}
@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzoneindex.h
+//
+//  CxZoneIndex Class
+//
+//  Finds a zone's channel from its id (K_W_W) without walking the zone list.  The index is a fixed
+//  open addressing table built once at load, each slot keeps the full hash and the channel so a probe
+//  only compares strings when the hashes already match.  The table is kept at most half full, with
+//  FNV-1a hashing a lookup is almost always a single probe.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxZoneIndex_h_
+#define _CxZoneIndex_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define ZONE_INDEX_SLOTS   128          // power of two, at least twice the number of zones
+#define ZONE_INDEX_NONE    -1
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxZoneIndex
+//
+//------------------------------------------------------------------------------------------------------------
+class CxZoneIndex
+{
+  public:
+
+    CxZoneIndex( void );
+    // constructor
+
+    int add( const char *id, int channel );
+    // index a zone id.  The id is not copied and must stay put.  An id already in the table keeps
+    // its first channel.  Returns FALSE if the table is full
+
+    int find( const char *id, int len=-1 ) const;
+    // channel for an id, or the first len characters of one, ZONE_INDEX_NONE if not found
+
+    int entries( void ) const;
+    // ids in the table
+
+    int maxProbe( void ) const;
+    // longest probe sequence any id needed when added
+
+  private:
+
+    struct Slot {
+        uint32_t    hash;
+        const char *id;
+        int16_t     channel;
+    };
+
+    static int matches( const char *id, const char *key, int len );
+    // TRUE if key, or its first len characters, equals id
+
+    Slot _slots[ ZONE_INDEX_SLOTS ];
+    int  _entries;
+    int  _maxProbe;
+};
+
+
+#endif
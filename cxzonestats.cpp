@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzonestats.cpp
+//
+//  CxZoneStats Class
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+#include <cxzonestats.h>
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::CxZoneStats
+//
+//------------------------------------------------------------------------------------------------------------
+CxZoneStats::CxZoneStats( void )
+: _openBits( 0 )
+{
+    memset( _entries, 0, sizeof( _entries ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::begin
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZoneStats::begin( uint64_t activatedBits, unsigned long nowMillis )
+{
+    _openBits = activatedBits;
+
+    for (int c=0; c<ZONE_STATS_CHANNELS; c++) {
+        if ((activatedBits >> c) & 1) {
+            _entries[ c ].openedMillis = nowMillis;
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::record
+//
+// An open is counted when it starts, its time when it ends.
+//
+//------------------------------------------------------------------------------------------------------------
+void
+CxZoneStats::record( int channel, int activated, unsigned long nowMillis, unsigned long nowTime )
+{
+    if (channel < 0 || channel >= ZONE_STATS_CHANNELS) return;
+
+    CxZoneStatsEntry *e   = &_entries[ channel ];
+    uint64_t          bit = 1ULL << channel;
+
+    if (activated) {
+
+        if (_openBits & bit) return;
+
+        e->opens++;
+        e->openedMillis = nowMillis;
+        _openBits |= bit;
+
+    } else {
+
+        if (!(_openBits & bit)) return;
+
+        uint32_t seconds = (nowMillis - e->openedMillis) / 1000;
+
+        e->openSeconds += seconds;
+        if (seconds > e->longestSeconds) e->longestSeconds = seconds;
+        _openBits &= ~bit;
+    }
+
+    e->lastChange = nowTime;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::entry
+//
+//------------------------------------------------------------------------------------------------------------
+const CxZoneStatsEntry *
+CxZoneStats::entry( int channel ) const
+{
+    if (channel < 0 || channel >= ZONE_STATS_CHANNELS) return( NULL );
+    return( &_entries[ channel ] );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::format
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneStats::format( int channel, char *buffer, int size, unsigned long nowMillis ) const
+{
+    const CxZoneStatsEntry *e = entry( channel );
+    if (e == NULL) return( 0 );
+
+    unsigned long openNow = 0;
+    if ((_openBits >> channel) & 1) {
+        openNow = (nowMillis - e->openedMillis) / 1000;
+    }
+
+    return( snprintf( buffer, size,
+        "{\"channel\":%d,\"opens\":%lu,\"open_s\":%lu,\"longest_s\":%lu,\"last_change\":%lu,\"open_now_s\":%lu}",
+        channel, (unsigned long) e->opens, (unsigned long) e->openSeconds,
+        (unsigned long) e->longestSeconds, (unsigned long) e->lastChange, openNow ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStats::formatSummary
+//
+// Walks the whole table, which is fine for the once an hour heartbeat.
+//
+//------------------------------------------------------------------------------------------------------------
+int
+CxZoneStats::formatSummary( char *buffer, int size ) const
+{
+    unsigned long total   = 0;
+    int           busiest = -1;
+    int           longest = -1;
+
+    for (int c=0; c<ZONE_STATS_CHANNELS; c++) {
+
+        const CxZoneStatsEntry *e = &_entries[ c ];
+        total += e->opens;
+
+        if (e->opens && (busiest < 0 || e->opens > _entries[ busiest ].opens)) {
+            busiest = c;
+        }
+
+        if (e->longestSeconds && (longest < 0 || e->longestSeconds > _entries[ longest ].longestSeconds)) {
+            longest = c;
+        }
+    }
+
+    return( snprintf( buffer, size, "[%lu,%d,%d]", total, busiest, longest ));
+}
@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzonestats.h
+//
+//  CxZoneStats Class
+//
+//  Running activity figures for every channel: how many times it opened, how long it has been open
+//  in total, its longest single open and when it last changed.  The table is a fixed array sized
+//  for the whole chain (20 bytes a channel) and is only touched when a zone changes state, so a
+//  quiet scan costs nothing.  Durations are measured on millis() so they are right even before the
+//  cloud has set the clock, the last change time is seconds from epoch.
+//
+//------------------------------------------------------------------------------------------------------------
+// MIT License
+//
+// Copyright (c) 2017 Todd Vernon
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _CxZoneStats_h_
+#define _CxZoneStats_h_
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define ZONE_STATS_CHANNELS  48
+
+
+//------------------------------------------------------------------------------------------------------------
+// CxZoneStatsEntry
+//
+//------------------------------------------------------------------------------------------------------------
+struct CxZoneStatsEntry
+{
+    uint32_t opens;
+    uint32_t openSeconds;                   // total time open, not counting the current open
+    uint32_t longestSeconds;                // longest completed open
+    uint32_t lastChange;                    // seconds from epoch, zero if it hasn't changed
+    uint32_t openedMillis;                  // millis() when the current open started
+};
+
+
+//------------------------------------------------------------------------------------------------------------
+// class CxZoneStats
+//
+//------------------------------------------------------------------------------------------------------------
+class CxZoneStats
+{
+  public:
+
+    CxZoneStats( void );
+    // constructor
+
+    void begin( uint64_t activatedBits, unsigned long nowMillis );
+    // start timing the zones that are already open
+
+    void record( int channel, int activated, unsigned long nowMillis, unsigned long nowTime );
+    // a zone changed state
+
+    const CxZoneStatsEntry *entry( int channel ) const;
+    // the figures for one channel, NULL if out of range
+
+    int format( int channel, char *buffer, int size, unsigned long nowMillis ) const;
+    // {"channel":n,"opens":n,"open_s":n,"longest_s":n,"last_change":t,"open_now_s":n}
+
+    int formatSummary( char *buffer, int size ) const;
+    // [total opens,busiest channel,channel with the longest open], -1 for a channel if nothing opened
+
+  private:
+
+    CxZoneStatsEntry _entries[ ZONE_STATS_CHANNELS ];
+    uint64_t         _openBits;
+};
+
+
+#endif
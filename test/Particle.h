@@ -0,0 +1,252 @@
+//------------------------------------------------------------------------------------------------------------
+//  Particle.h
+//
+//  Host stand-in for the Device OS header, just enough for the classes under test and the firmware
+//  itself to build on a desktop compiler.  Found ahead of the real one because the makefile puts this
+//  directory first on the include path.
+//
+//  Time is simulated.  delay() on the thread that runs the firmware moves the clock on and fires any
+//  software timers that come due, delay() on any other thread (the publisher) waits for the clock to
+//  get there, so a slow cloud never slows the test down.  The pins drive a model of the input and
+//  output shift register chains.  host.h has the calls a test uses to set all of this up and look at
+//  what came out.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _Particle_h_
+#define _Particle_h_
+
+#define EEPROM_HOST_BYTES 2048
+
+typedef unsigned char byte;
+
+//
+// pins
+//
+enum { D0, D1, D2, D3, D4, D5, D6, D7, A0, A1, A2, A3, A4, A5, A6, A7, HOST_PINS };
+enum { LOW = 0, HIGH = 1 };
+enum PinMode { INPUT, OUTPUT, INPUT_PULLUP, INPUT_PULLDOWN };
+
+void pinMode( int pin, PinMode mode );
+void digitalWrite( int pin, int value );
+int  digitalRead( int pin );
+
+//
+// time
+//
+unsigned long millis( void );
+unsigned long micros( void );
+void          delay( unsigned long ms );
+void          delayMicroseconds( unsigned int us );
+
+long random( long max );
+long random( long min, long max );
+
+//
+// just the parts of String the firmware uses, held in place so it never allocates
+//
+class String
+{
+  public:
+
+    String( void ) { _text[0] = 0; }
+    String( const char *text ) { snprintf( _text, sizeof( _text ), "%s", text ? text : "" ); }
+
+    const char *c_str( void ) const { return( _text ); }
+    unsigned int length( void ) const { return( strlen( _text )); }
+
+  private:
+
+    char _text[ 640 ];
+};
+
+class TimeClass
+{
+  public:
+
+    time_t now( void );
+    int    isValid( void );
+};
+
+extern TimeClass Time;
+
+enum { FEATURE_RETAINED_MEMORY = 1 };
+
+class SystemClass
+{
+  public:
+
+    uint32_t freeMemory( void );
+    uint32_t ticks( void );
+    uint32_t ticksPerMicrosecond( void );
+    void     enableFeature( int feature );
+    String   deviceID( void );
+};
+
+extern SystemClass System;
+
+//
+// the cloud
+//
+class CloudClass
+{
+  public:
+
+    bool connected( void );
+    bool publish( const char *name, const char *data );
+
+    bool variable( const char *name, int *value );
+    bool variable( const char *name, double *value );
+    bool variable( const char *name, char *value );
+    bool variable( const char *name, const char *value );
+
+    bool function( const char *name, int (*handler)( String ));
+};
+
+extern CloudClass Particle;
+
+//
+// EEPROM, erased (all 0xFF) at start up like a fresh device, particle.cpp holds the one instance
+//
+class EEPROMClass
+{
+  public:
+
+    EEPROMClass( void ) { clear(); }
+
+    void clear( void ) { memset( _data, 0xFF, sizeof( _data )); }
+
+    size_t length( void ) const { return( sizeof( _data )); }
+
+    uint8_t read( int address ) const { return( _data[ address ] ); }
+
+    void write( int address, uint8_t value ) { _data[ address ] = value; }
+
+    template <typename T> T& get( int address, T& value ) const {
+        memcpy( &value, _data + address, sizeof( T ));
+        return( value );
+    }
+
+    template <typename T> const T& put( int address, const T& value ) {
+        memcpy( _data + address, &value, sizeof( T ));
+        return( value );
+    }
+
+  private:
+
+    uint8_t _data[ EEPROM_HOST_BYTES ];
+};
+
+extern EEPROMClass EEPROM;
+
+//
+// threads and queues
+//
+typedef void *os_queue_t;
+typedef void (*os_thread_fn_t)( void *arg );
+typedef int   os_thread_prio_t;
+
+#define CONCURRENT_WAIT_FOREVER    ((unsigned long) -1)
+#define OS_THREAD_PRIORITY_DEFAULT 2
+
+int os_queue_create( os_queue_t *queue, size_t itemSize, size_t itemCount, void *reserved );
+int os_queue_put( os_queue_t queue, const void *item, unsigned long delay, void *reserved );
+int os_queue_take( os_queue_t queue, void *item, unsigned long delay, void *reserved );
+
+class Thread
+{
+  public:
+
+    Thread( const char *name, os_thread_fn_t function, void *arg, os_thread_prio_t priority, size_t stackSize );
+};
+
+//
+// software timers, fired from delay() on the firmware thread as the clock passes them
+//
+class Timer
+{
+  public:
+
+    template <typename T>
+    Timer( unsigned int period, void (T::*handler)( void ), T& instance, bool oneShot = false )
+    : _period( period ),
+      _oneShot( oneShot ),
+      _object( &instance ),
+      _call( &Timer::invoke<T> ),
+      _due( 0 ),
+      _active( false ),
+      _next( NULL )
+    {
+        memcpy( _handler, &handler, sizeof( handler ));
+        static_assert( sizeof( handler ) <= sizeof( _handler ), "member pointer too big" );
+    }
+
+    bool start( void );
+    bool stop( void );
+    bool isActive( void ) const { return( _active ); }
+
+    static void fireDue( unsigned long nowMillis );
+    // run every active timer due at or before nowMillis
+
+  private:
+
+    template <typename T>
+    static void invoke( Timer *timer ) {
+        void (T::*handler)( void );
+        memcpy( &handler, timer->_handler, sizeof( handler ));
+        (((T *) timer->_object)->*handler)();
+    }
+
+    unsigned int  _period;
+    bool          _oneShot;
+    void         *_object;
+    void        (*_call)( Timer *timer );
+    char          _handler[ 16 ];
+    unsigned long _due;
+    bool          _active;
+    Timer        *_next;
+
+    static Timer *_timers;
+};
+
+//
+// interrupts are off for an ATOMIC_BLOCK, here one lock shared by every thread
+//
+class HostAtomicBlock
+{
+  public:
+
+    HostAtomicBlock( void );
+    ~HostAtomicBlock( void );
+
+    bool once( void ) { return( _once ? (_once = false, true) : false ); }
+
+  private:
+
+    bool _once;
+};
+
+#define ATOMIC_BLOCK()           for (HostAtomicBlock hostBlock; hostBlock.once(); )
+#define SINGLE_THREADED_BLOCK()  ATOMIC_BLOCK()
+
+#define __DMB()                  __sync_synchronize()
+
+//
+// retained variables share one section so host.h can save and restore them across a "reset"
+//
+#define retained                 __attribute__(( section( "retained_user" )))
+
+#define HOST_PASTE( a, b )       a ## b
+#define HOST_UNIQUE( a, b )      HOST_PASTE( a, b )
+#define STARTUP( x )             static int HOST_UNIQUE( hostStartup, __LINE__ ) __attribute__(( unused )) = ((x), 0)
+#define SYSTEM_THREAD( x )       enum { HOST_UNIQUE( hostSystemThread, __LINE__ ) }
+
+
+#endif
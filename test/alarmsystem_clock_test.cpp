@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_clock_test.cpp
+//
+//  Runs the firmware on the host starting up before the cloud has set the clock.  Nothing may go out
+//  stamped with a 1970 time: the first scan's transitions and anything that moves before the clock is
+//  set wait, and go out with the zones as they are once it has been.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "check.h"
+
+#define GARAGE_WINDOW     1                 // no entry or exit delay
+#define KITCHEN_WINDOW    8
+#define BASEMENT_WINDOW   5
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+static int published_zone( int channel, int open )
+{
+    HostPublish publish;
+    char        number[ 32 ];
+    int         found = 0;
+
+    snprintf( number, sizeof( number ), "{\"channel_number\":\"%d\"", channel + 1 );
+
+    for (int back = 0; host_published( back, &publish ); back++) {
+        if (strncmp( publish.data, number, strlen( number )) == 0 &&
+            strstr( publish.data, open ? "is OPEN" : "is CLOSED" ) != NULL) found++;
+    }
+    return( found );
+}
+
+static int all_stamped_after_clock_set( void )
+{
+    HostPublish publish;
+
+    for (int back = 0; host_published( back, &publish ); back++) {
+
+        const char *start = strstr( publish.data, "\"state_start_time\":" );
+        if (start == NULL) continue;
+
+        start += strlen( "\"state_start_time\":" );
+        if (*start == '"') start++;
+
+        if (strtoul( start, NULL, 10 ) < 1700000000UL) return( FALSE );
+    }
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_held_until_clock_set
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_held_until_clock_set( void )
+{
+    // the garage window was open at reset and the kitchen window opens before the clock is set, the
+    // basement window opens and shuts again in that time
+
+    run_loops( 8 );
+    host_set_inputs( (1ULL << GARAGE_WINDOW) | (1ULL << KITCHEN_WINDOW) | (1ULL << BASEMENT_WINDOW) );
+    run_loops( 8 );
+    host_set_inputs( (1ULL << GARAGE_WINDOW) | (1ULL << KITCHEN_WINDOW) );
+    run_loops( 40 );
+
+    CHECK( host_publishes() == 0 );
+    CHECK( publisher.depth() == 0 );
+
+    // the relay never waited for the clock
+
+    CHECK( host_pin( A0 ) == LOW );
+
+    // once it is set the zones go out as they are now, along with the restart message
+
+    host_set_time_valid( TRUE );
+    run_loops( 40 );
+
+    CHECK( published_zone( GARAGE_WINDOW, TRUE ) == 1 );
+    CHECK( published_zone( KITCHEN_WINDOW, TRUE ) == 1 );
+    CHECK( published_zone( BASEMENT_WINDOW, TRUE ) == 0 );
+    CHECK( published_zone( BASEMENT_WINDOW, FALSE ) == 0 );
+    CHECK( all_stamped_after_clock_set( ));
+
+    // and from then on a transition goes out as it happens
+
+    unsigned long before = host_publishes();
+
+    host_set_inputs( 1ULL << KITCHEN_WINDOW );
+    run_loops( 8 );
+
+    CHECK( host_publishes() > before );
+    CHECK( published_zone( GARAGE_WINDOW, FALSE ) == 1 );
+    CHECK( all_stamped_after_clock_set( ));
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+    host_set_time_valid( FALSE );
+    host_set_inputs( 1ULL << GARAGE_WINDOW );
+
+    setup( );
+
+    test_held_until_clock_set( );
+
+    return( check_report( "alarmsystem_clock" ));
+}
@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_cloud_test.cpp
+//
+//  Runs the firmware on the host against a slow cloud.  Every publish takes ten seconds, far longer
+//  than a scan, and the zones keep changing so the publisher queue fills.  The scan has to keep its
+//  cadence and the relay has to follow the zones while that happens, and once the cloud catches up
+//  every transition has to have reached it.  Also checks a publisher queue that can't be created is
+//  reported rather than silently sending nothing.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "check.h"
+
+#define SLOW_PUBLISH_MS   10000
+#define FIRST_WINDOW      4                 // the basement, kitchen and family room have no entry delays
+#define OPENINGS          12                // more transitions than the queue holds
+#define OPENING_PASSES    8                 // one every two seconds
+
+static unsigned long longestPassMs = 0;
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        unsigned long start = millis();
+        loop( );
+        if (millis() - start > longestPassMs) longestPassMs = millis() - start;
+    }
+}
+
+static int published_named( const char *name )
+{
+    HostPublish publish;
+    int         found = 0;
+
+    for (int back = 0; host_published( back, &publish ); back++) {
+        if (strcmp( publish.name, name ) == 0) found++;
+    }
+    return( found );
+}
+
+static int published_zone( int channel )
+{
+    HostPublish publish;
+    char        number[ 32 ];
+    int         found = 0;
+
+    snprintf( number, sizeof( number ), "{\"channel_number\":\"%d\"", channel + 1 );
+
+    for (int back = 0; host_published( back, &publish ); back++) {
+        if (strncmp( publish.data, number, strlen( number )) == 0) found++;
+    }
+    return( found );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_queue_create_failure
+//
+// setup() ran with os_queue_create failing.  The first pass with the cloud up says so directly.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_queue_create_failure( void )
+{
+    CHECK( publisherFailed );
+    CHECK( !publisher.enqueue( "access_changed", "{}", 0 ));
+
+    run_loops( 1 );
+
+    CHECK( !publisherFailed );
+    CHECK( published_named( "publisher_failed" ) == 1 );
+
+    // the queue is there on a second try, and the rest of the tests use it
+
+    CHECK( publisher.begin( ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_scan_cadence
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_scan_cadence( void )
+{
+    // a quiet minute with a fast cloud gives the normal length of a pass
+
+    run_loops( 240 );
+
+    unsigned long normalPassMs = longestPassMs;
+    unsigned long droppedBefore = publisher.dropped();
+    unsigned long publishedBefore = publisher.published();
+
+    CHECK( normalPassMs >= 250 );
+
+    // now every publish takes ten seconds and the windows open one after another
+
+    host_set_cloud( TRUE, SLOW_PUBLISH_MS, FALSE );
+    longestPassMs = 0;
+
+    uint64_t open     = 0;
+    int      maxDepth = 0;
+
+    for (int w = 0; w < OPENINGS; w++) {
+
+        open |= 1ULL << (FIRST_WINDOW + w);
+        host_set_inputs( open );
+
+        for (int i = 0; i < OPENING_PASSES; i++) {
+
+            run_loops( 1 );
+
+            // the relay is driven from the scan, the cloud has nothing to do with it
+
+            CHECK( host_pin( A0 ) == LOW );
+
+            if (publisher.depth() > maxDepth) maxDepth = publisher.depth();
+        }
+    }
+
+    CHECK( longestPassMs == normalPassMs );
+    CHECK( maxDepth == PUBLISH_QUEUE_DEPTH );
+    CHECK( publisher.dropped() > droppedBefore );
+    CHECK( publisher.published() - publishedBefore < OPENINGS );
+
+    // the transitions that didn't fit waited in the checkpoint backlog, nothing is lost once the cloud
+    // catches up
+
+    run_loops( 2 * OPENINGS * SLOW_PUBLISH_MS / 250 );
+
+    CHECK( longestPassMs == normalPassMs );
+    CHECK( publisher.depth() == 0 );
+    CHECK( publisher.failed() == 0 );
+
+    for (int w = 0; w < OPENINGS; w++) {
+        CHECK( published_zone( FIRST_WINDOW + w ) == 1 );
+    }
+
+    CHECK( checkpoint.backlogEntries() == 0 );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+    host_fail_queue_create( TRUE );
+
+    setup( );
+
+    test_queue_create_failure( );
+    test_scan_cadence( );
+
+    return( check_report( "alarmsystem_cloud" ));
+}
@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_command_test.cpp
+//
+//  Runs the firmware on the host and drives the "cmd" Particle function the way the cloud would.  The
+//  commands that take a zone have to resolve ids for the zones in use only, and take channel numbers
+//  within the channel map only.  A number too big for a long is refused, not wrapped onto a channel.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <limits.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "check.h"
+
+#define GARAGE_WINDOW     1
+#define BEDROOM_2_WINDOW  26                // INACTIVE in the channel map
+#define FIRST_UNUSED      30                // the unused channels all have the id "X"
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_zone_ids
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_zone_ids( void )
+{
+    host_set_inputs( 1ULL << GARAGE_WINDOW );
+    run_loops( 8 );
+
+    // open, and alarming since a cold start is AWAY
+
+    CHECK( run_command( "zone G_E_W" ) == 5 );
+    CHECK( run_command( "zone 1" ) == 5 );
+
+    // the unused channels and the zones not in use have no id as far as the commands go
+
+    CHECK( run_command( "zone X" ) == -1 );
+    CHECK( run_command( "stats X" ) == -1 );
+    CHECK( run_command( "zone B2_E_W" ) == -1 );
+    CHECK( zoneIndex.find( "X" ) == ZONE_INDEX_NONE );
+
+    // though they can still be named by channel
+
+    CHECK( run_command( "zone 30" ) == 0 );
+    CHECK( run_command( "zone 48" ) == -1 );
+
+    // only the 26 zones in use are indexed, the delay and schedule tables match ids against the whole
+    // map so a zone the cloud turns on later keeps them
+
+    CHECK( zoneIndex.entries() == 26 );
+    CHECK( channel_map_find( "B2_E_W" ) == BEDROOM_2_WINDOW );
+    CHECK( channel_map_find( "X" ) == FIRST_UNUSED );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_numbers
+//
+//------------------------------------------------------------------------------------------------------------
+
+static int token_long( const char *text, long *value )
+{
+    CxTokenizer tokens( text, " " );
+    CxToken     token;
+
+    tokens.next( &token );
+    return( token.toLong( value ));
+}
+
+static void test_numbers( void )
+{
+    char text[ 32 ];
+    long value = 7;
+
+    // the limits themselves still parse
+
+    snprintf( text, sizeof( text ), "%ld", LONG_MAX );
+    CHECK( token_long( text, &value ) && value == LONG_MAX );
+
+    snprintf( text, sizeof( text ), "%ld", LONG_MIN );
+    CHECK( token_long( text, &value ) && value == LONG_MIN );
+
+    CHECK( token_long( "-0", &value ) && value == 0 );
+
+    // one past them doesn't, and leaves the value alone
+
+    snprintf( text, sizeof( text ), "%lu", (unsigned long) LONG_MAX + 1 );
+    CHECK( !token_long( text, &value ) && value == 0 );
+
+    snprintf( text, sizeof( text ), "-%lu", (unsigned long) LONG_MAX + 2 );
+    CHECK( !token_long( text, &value ) && value == 0 );
+
+    CHECK( !token_long( "99999999999999999999999", &value ));
+
+    // channel 1 once wrapped at 32 and 64 bits
+
+    CHECK( run_command( "zone 4294967297" ) == -1 );
+    CHECK( run_command( "zone 18446744073709551617" ) == -1 );
+    CHECK( run_command( "zone 99999999999" ) == -1 );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+
+    setup( );
+
+    test_zone_ids( );
+    test_numbers( );
+
+    return( check_report( "alarmsystem_command" ));
+}
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_compact_test.cpp
+//
+//  Runs the firmware on the host built with USE_COMPACT_EVENTS and expands what it publishes with the
+//  receiving side decoder.  Every transition has to come back as its own VictorOps message with its
+//  own sequence number, event key and severity, the same as without compact events.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "compact_expand.h"
+#include "check.h"
+
+#define GARAGE_WINDOW     1                 // no entry or exit delay
+#define KITCHEN_WINDOW    8
+#define EXPANDED_MAX      16
+
+static char expanded[ EXPANDED_MAX ][ HOST_PUBLISH_DATA ];
+static int  expandedCount;
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+static void keep_json( const char *json, void *arg )
+{
+    (void) arg;
+
+    if (expandedCount < EXPANDED_MAX) {
+        snprintf( expanded[ expandedCount ], sizeof( expanded[0] ), "%s", json );
+    }
+    expandedCount++;
+}
+
+static unsigned long field_number( const char *json, const char *name )
+{
+    char        key[ 64 ];
+    const char *at;
+
+    snprintf( key, sizeof( key ), "\"%s\":", name );
+    at = strstr( json, key );
+    if (at == NULL) return( 0 );
+
+    at += strlen( key );
+    if (*at == '"') at++;
+
+    return( strtoul( at, NULL, 10 ));
+}
+
+static int expand_published( void )
+{
+    HostPublish publish;
+    int         batches = 0;
+
+    expandedCount = 0;
+
+    // oldest first so the transitions come out in order
+
+    int back = 0;
+    while (host_published( back + 1, &publish )) back++;
+
+    for (; back >= 0; back--) {
+        host_published( back, &publish );
+        if (strstr( publish.data, "\"encoding\":\"zd2\"" ) == NULL) continue;
+
+        CHECK( compact_expand( publish.data, keep_json, NULL ) > 0 );
+        batches++;
+    }
+    return( batches );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_expanded_transitions
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_expanded_transitions( void )
+{
+    run_loops( 8 );
+
+    unsigned long firstSequence = checkpoint.sequence() + 1;
+
+    // two windows in one scan, then one of them shuts
+
+    host_set_inputs( (1ULL << GARAGE_WINDOW) | (1ULL << KITCHEN_WINDOW) );
+    run_loops( 8 );
+    host_set_inputs( 1ULL << KITCHEN_WINDOW );
+    run_loops( 40 );
+
+    CHECK( expand_published( ) == 2 );
+    CHECK( expandedCount == 3 );
+
+    if (expandedCount != 3) return;
+
+    // each transition has its own sequence and key, in the order they happened.  The room events
+    // took the sequence numbers in between, which a per batch sequence couldn't show
+
+    CHECK( field_number( expanded[0], "seq" ) == firstSequence );
+    CHECK( field_number( expanded[1], "seq" ) == firstSequence + 1 );
+    CHECK( field_number( expanded[2], "seq" ) > firstSequence + 2 );
+
+    char key[ 64 ];
+    snprintf( key, sizeof( key ), "\"event_key\":\"%s-%lu\"", deviceId.data(), firstSequence + 1 );
+    CHECK( strstr( expanded[1], key ) != NULL );
+
+    CHECK( field_number( expanded[0], "channel_number" ) == GARAGE_WINDOW + 1 );
+    CHECK( field_number( expanded[1], "channel_number" ) == KITCHEN_WINDOW + 1 );
+    CHECK( field_number( expanded[2], "channel_number" ) == GARAGE_WINDOW + 1 );
+
+    // and the severity the firmware gave it, a window opening is CRITICAL in AWAY, where a cold start
+    // leaves the system
+
+    CHECK( arming.mode() == ARM_AWAY );
+    CHECK( strstr( expanded[0], "is OPEN" ) != NULL );
+    CHECK( strstr( expanded[0], "\"message_type\":\"CRITICAL\"" ) != NULL );
+    CHECK( strstr( expanded[1], "\"message_type\":\"CRITICAL\"" ) != NULL );
+    CHECK( strstr( expanded[2], "is CLOSED" ) != NULL );
+    CHECK( strstr( expanded[2], "\"message_type\":\"RECOVERY\"" ) != NULL );
+
+    CHECK( field_number( expanded[0], "state_start_time" ) >= 1700000000UL );
+
+    // the cloud has confirmed them all
+
+    CHECK( checkpoint.backlogEntries() == 0 );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+
+    setup( );
+
+    test_expanded_transitions( );
+
+    return( check_report( "alarmsystem_compact" ));
+}
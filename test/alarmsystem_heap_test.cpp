@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_heap_test.cpp
+//
+//  Runs the firmware on the host with USE_HEAP_STATS and holds loop() to its steady state allocation
+//  budget (HEAP_ITERATION_BUDGET, none at all).  Passes that send something are allowed to allocate,
+//  passes that don't are counted as overruns if they do, and the test fails on any overrun.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "check.h"
+
+#define STEADY_PASSES   400                 // 100 seconds of loop()
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_steady_state
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_steady_state( void )
+{
+    // startup and the restart message can allocate, the passes after that can't
+
+    run_loops( 40 );
+
+    unsigned long allocations = CxHeapStats::allocations();
+
+    run_loops( STEADY_PASSES );
+
+    CHECK( CxHeapStats::allocations() == allocations );
+    CHECK( CxHeapStats::overruns() == 0 );
+
+    // the garage window opening and shutting sends events, which may allocate but isn't steady state
+
+    host_set_inputs( 1ULL << 1 );
+    run_loops( 20 );
+    host_set_inputs( 0 );
+    run_loops( 20 );
+
+    CHECK( publisher.published() > 0 );
+    CHECK( CxHeapStats::overruns() == 0 );
+
+    // and once things are quiet again nothing is allocated
+
+    allocations = CxHeapStats::allocations();
+
+    run_loops( STEADY_PASSES );
+
+    CHECK( CxHeapStats::allocations() == allocations );
+    CHECK( CxHeapStats::overruns() == 0 );
+    CHECK( CxHeapStats::bytesInUse() <= CxHeapStats::peakBytes() );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+
+    setup( );
+
+    test_steady_state( );
+
+    return( check_report( "alarmsystem_heap" ));
+}
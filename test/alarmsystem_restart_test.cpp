@@ -0,0 +1,245 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_restart_test.cpp
+//
+//  Runs the firmware on the host across resets.  Each reset saves the retained memory and EEPROM to a
+//  file and starts this test again as a new process, which loads them before setup().  A warm restart
+//  has to come back with the zones as the cloud last heard them, resend the one transition that wasn't
+//  confirmed under its original sequence number and not page again for a window that was already
+//  reported.  A checkpoint that fails its crc has to give a cold start that still never reuses a
+//  sequence number.
+//
+//      alarmsystem_restart_test                                       the cold start, runs the others
+//      alarmsystem_restart_test warm|corrupt <file> <resent> <last>
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "check.h"
+#include <unistd.h>
+
+#define LIVING_WINDOW     4                 // no entry delay
+#define KITCHEN_WINDOW    8                 // no entry delay
+#define SEQUENCE_OFFSET   8                 // of CxCheckpointImage::sequence, the first thing retained
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+static int published_zone( int channel, unsigned long *sequence )
+{
+    HostPublish publish;
+    char        number[ 32 ];
+    int         found = 0;
+
+    snprintf( number, sizeof( number ), "{\"channel_number\":\"%d\"", channel + 1 );
+
+    for (int back = 0; host_published( back, &publish ); back++) {
+        if (strncmp( publish.data, number, strlen( number )) == 0) {
+            const char *seq = strstr( publish.data, "\"seq\":" );
+            if (sequence && seq) *sequence = strtoul( seq + strlen( "\"seq\":" ), NULL, 10 );
+            found++;
+        }
+    }
+    return( found );
+}
+
+static int restart_payload( HostPublish *publish )
+{
+    for (int back = 0; host_published( back, publish ); back++) {
+        if (strstr( publish->data, "\"entity_id\":\"SYSTEM_RESTART\"" )) return( TRUE );
+    }
+    return( FALSE );
+}
+
+static unsigned long field_number( const char *json, const char *name )
+{
+    char        key[ 64 ];
+    const char *at;
+
+    snprintf( key, sizeof( key ), "\"%s\":", name );
+    at = strstr( json, key );
+    return( at ? strtoul( at + strlen( key ), NULL, 10 ) : 0 );
+}
+
+static void reset( const char *self, const char *phase, const char *path, unsigned long resent, unsigned long last )
+{
+    char resentText[ 16 ];
+    char lastText[ 16 ];
+
+    snprintf( resentText, sizeof( resentText ), "%lu", resent );
+    snprintf( lastText, sizeof( lastText ), "%lu", last );
+
+    fflush( stdout );
+    execl( self, self, phase, path, resentText, lastText, (char *) NULL );
+
+    perror( self );
+    CHECK( FALSE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_cold_start
+//
+// the kitchen window is reported and confirmed, then the living room window opens with the cloud
+// down and the device resets before it is sent
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_cold_start( const char *self, const char *path )
+{
+    HostPublish publish;
+
+    setup( );
+    run_loops( 8 );
+
+    CHECK( !checkpoint.warm() );
+    CHECK( restart_payload( &publish ) && strstr( publish.data, "\"start_type\":\"COLD\"" ));
+
+    host_set_inputs( 1ULL << KITCHEN_WINDOW );
+    run_loops( 8 );
+
+    CHECK( published_zone( KITCHEN_WINDOW, NULL ) == 1 );
+
+    host_set_cloud( FALSE, 0, FALSE );
+    host_set_inputs( (1ULL << KITCHEN_WINDOW) | (1ULL << LIVING_WINDOW) );
+    run_loops( 8 );
+
+    CHECK( published_zone( LIVING_WINDOW, NULL ) == 0 );
+    CHECK( checkpoint.backlogEntries() == 1 );
+
+    if (checkpoint.backlogEntries() != 1) return;
+
+    unsigned long resent = checkpoint.backlogAt( 0 )->sequence;
+
+    CHECK( host_retained_save( path ));
+
+    if (checkFailures == 0) {
+        reset( self, "warm", path, resent, checkpoint.sequence() );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_warm_start
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_warm_start( const char *self, const char *path, unsigned long resent, unsigned long last )
+{
+    HostPublish   publish;
+    unsigned long sequence = 0;
+
+    host_set_inputs( (1ULL << KITCHEN_WINDOW) | (1ULL << LIVING_WINDOW) );
+
+    CHECK( host_retained_load( path ));
+
+    setup( );
+
+    // the zones are as the cloud last heard them before the first scan
+
+    CHECK( checkpoint.warm() );
+    CHECK( zoneTable[ KITCHEN_WINDOW ]->activated() );
+    CHECK( zoneTable[ LIVING_WINDOW ]->activated() );
+    CHECK( checkpointResent == 1 );
+
+    run_loops( 8 );
+
+    CHECK( restart_payload( &publish ));
+    CHECK( strstr( publish.data, "\"start_type\":\"WARM\"" ) != NULL );
+    CHECK( field_number( publish.data, "resent" ) == 1 );
+    CHECK( field_number( publish.data, "seq" ) > last );
+
+    // the unconfirmed transition goes out once under its own number, the kitchen doesn't page again
+
+    CHECK( published_zone( LIVING_WINDOW, &sequence ) == 1 );
+    CHECK( sequence == resent );
+    CHECK( published_zone( KITCHEN_WINDOW, NULL ) == 0 );
+    CHECK( checkpoint.backlogEntries() == 0 );
+
+    // reset again with the sequence number in the checkpoint broken
+
+    CHECK( host_retained_save( path ));
+
+    FILE *file = fopen( path, "r+b" );
+    CHECK( file != NULL );
+    if (file == NULL) return;
+
+    fseek( file, SEQUENCE_OFFSET, SEEK_SET );
+    int value = fgetc( file );
+    fseek( file, SEQUENCE_OFFSET, SEEK_SET );
+    fputc( value ^ 0x01, file );
+    fclose( file );
+
+    if (checkFailures == 0) {
+        reset( self, "corrupt", path, resent, checkpoint.sequence() );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_corrupt_start
+//
+// a cold start, both open windows are reported afresh and the sequence numbers resume past anything
+// used before from the reservation in EEPROM
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_corrupt_start( const char *path, unsigned long last )
+{
+    HostPublish publish;
+
+    host_set_inputs( (1ULL << KITCHEN_WINDOW) | (1ULL << LIVING_WINDOW) );
+
+    CHECK( host_retained_load( path ));
+    unlink( path );
+
+    setup( );
+    run_loops( 16 );
+
+    CHECK( !checkpoint.warm() );
+    CHECK( restart_payload( &publish ));
+    CHECK( strstr( publish.data, "\"start_type\":\"COLD\"" ) != NULL );
+    CHECK( field_number( publish.data, "seq" ) > last );
+
+    CHECK( published_zone( KITCHEN_WINDOW, NULL ) == 1 );
+    CHECK( published_zone( LIVING_WINDOW, NULL ) == 1 );
+}
+
+
+int main( int argc, char **argv )
+{
+    char path[ 64 ];
+
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+
+    if (argc == 1) {
+        snprintf( path, sizeof( path ), "/tmp/alarmsystem_restart.%d", (int) getpid() );
+        test_cold_start( argv[0], path );
+        unlink( path );
+        return( check_report( "alarmsystem_restart cold" ));
+    }
+
+    if (argc != 5) {
+        fprintf( stderr, "usage: %s [warm|corrupt <file> <resent> <last>]\n", argv[0] );
+        return( 2 );
+    }
+
+    unsigned long resent = strtoul( argv[3], NULL, 10 );
+    unsigned long last   = strtoul( argv[4], NULL, 10 );
+
+    if (strcmp( argv[1], "warm" ) == 0) {
+        test_warm_start( argv[0], argv[2], resent, last );
+        unlink( argv[2] );
+        return( check_report( "alarmsystem_restart warm" ));
+    }
+
+    test_corrupt_start( argv[2], last );
+
+    return( check_report( "alarmsystem_restart" ));
+}
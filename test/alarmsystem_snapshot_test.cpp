@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------------------------------------
+//  alarmsystem_snapshot_test.cpp
+//
+//  Runs the firmware on the host, asks it for zone snapshots with "cmd snapshot" and reconciles them
+//  the way the receiving side does.  A receiver holding an old snapshot has to get exactly the
+//  CRITICAL and RECOVERY messages for the zones that changed since, and nothing for an older one.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "host.h"
+#include "../alarmsystem.ino"
+#include "snapshot_actions.h"
+#include "check.h"
+
+#define KITCHEN_WINDOW    8                 // K_NC_W, no entry delay
+#define ACTIONS_MAX       4
+
+static char actionJson[ ACTIONS_MAX ][ HOST_PUBLISH_DATA ];
+static int  actionCount;
+
+static void run_loops( int passes )
+{
+    for (int i = 0; i < passes; i++) {
+        loop( );
+    }
+}
+
+static void keep_json( const char *json, void *arg )
+{
+    (void) arg;
+
+    if (actionCount < ACTIONS_MAX) {
+        snprintf( actionJson[ actionCount ], sizeof( actionJson[0] ), "%s", json );
+    }
+    actionCount++;
+}
+
+static int reconcile( const char *known, const char *current )
+{
+    actionCount = 0;
+    return( snapshot_actions( known, current, keep_json, NULL ));
+}
+
+static void take_snapshot( char *payload )
+{
+    HostPublish publish;
+
+    CHECK( run_command( "snapshot" ) > 0 );
+    run_loops( 8 );
+
+    payload[0] = 0;
+    for (int back = 0; host_published( back, &publish ); back++) {
+        if (strstr( publish.data, "\"entity_id\":\"SYSTEM_SNAPSHOT\"" )) {
+            strcpy( payload, publish.data );
+            break;
+        }
+    }
+    CHECK( payload[0] != 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_reconcile_snapshots
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_reconcile_snapshots( void )
+{
+    static char before[ HOST_PUBLISH_DATA ];
+    static char opened[ HOST_PUBLISH_DATA ];
+    static char closed[ HOST_PUBLISH_DATA ];
+
+    run_loops( 8 );
+    take_snapshot( before );
+
+    // the receiver lost the transition, the next snapshot says the window is open
+
+    host_set_inputs( 1ULL << KITCHEN_WINDOW );
+    run_loops( 8 );
+    take_snapshot( opened );
+
+    CHECK( reconcile( before, opened ) == 1 );
+    CHECK( actionCount == 1 );
+    CHECK( strstr( actionJson[0], "\"entity_id\":\"K_NC_W\"" ) != NULL );
+    CHECK( strstr( actionJson[0], "\"message_type\":\"CRITICAL\"" ) != NULL );
+    CHECK( strstr( actionJson[0], "is OPEN" ) != NULL );
+    CHECK( strstr( actionJson[0], "\"seq\"" ) == NULL );
+
+    const char *time = strstr( actionJson[0], "\"state_start_time\":" );
+    CHECK( time != NULL && strtoul( time + strlen( "\"state_start_time\":" ), NULL, 10 ) >= 1700000000UL );
+
+    // then it shuts
+
+    host_set_inputs( 0 );
+    run_loops( 8 );
+    take_snapshot( closed );
+
+    CHECK( reconcile( opened, closed ) == 1 );
+    CHECK( strstr( actionJson[0], "\"entity_id\":\"K_NC_W\"" ) != NULL );
+    CHECK( strstr( actionJson[0], "\"message_type\":\"RECOVERY\"" ) != NULL );
+
+    // a receiver that missed both is already right, and the same state needs nothing
+
+    CHECK( reconcile( before, closed ) == 0 );
+    CHECK( reconcile( closed, closed ) == 0 );
+    CHECK( actionCount == 0 );
+
+    // an older snapshot is refused, and a payload without one isn't a snapshot
+
+    CHECK( reconcile( closed, opened ) == -1 );
+    CHECK( actionCount == 0 );
+    CHECK( reconcile( before, "{\"entity_id\":\"SYSTEM_MODE\"}" ) == -2 );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, TOTAL_CHANNELS, CHAIN_SERIAL_LEVEL );
+    host_output_chain( D6, D5, D4 );
+
+    setup( );
+
+    test_reconcile_snapshots( );
+
+    return( check_report( "alarmsystem_snapshot" ));
+}
@@ -0,0 +1,34 @@
+//------------------------------------------------------------------------------------------------------------
+//  bench.h
+//
+//  Timing helper for the host benchmarks.  They print what they measure rather than pass or fail on
+//  it, a desktop is far faster than the Photon's 120MHz Cortex-M3 so the figures are for comparing one
+//  build of a class against another, not for reading off a budget.  A benchmark still fails if the
+//  work it timed gave the wrong answer.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <time.h>
+
+#ifndef _bench_h_
+#define _bench_h_
+
+static inline double bench_seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec + ts.tv_nsec / 1e9 );
+}
+
+static void bench_report( const char *what, double seconds, unsigned long operations )
+{
+    printf( "  %-44s %10.1f ns\n", what, operations ? seconds * 1e9 / operations : 0.0 );
+}
+
+// keeps a result alive so the optimizer can't drop the work that made it
+static volatile unsigned long benchSink;
+
+
+#endif
@@ -0,0 +1,31 @@
+//------------------------------------------------------------------------------------------------------------
+//  check.h
+//
+//  The smallest possible test helper for the host tests.  CHECK reports the failing expression and
+//  keeps going so one run shows every failure, check_report() gives the exit status.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#ifndef _check_h_
+#define _check_h_
+
+static int checkFailures = 0;
+
+#define CHECK( expr ) \
+    do { \
+        if (!(expr)) { \
+            printf( "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr ); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+static int check_report( const char *name )
+{
+    printf( "%s: %s\n", name, checkFailures ? "FAILED" : "ok" );
+    return( checkFailures ? 1 : 0 );
+}
+
+
+#endif
@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------------------------------------
+//  compact_decode.cpp
+//
+//  Receiving side tool for USE_COMPACT_EVENTS.  Reads compact access_changed payloads from stdin, one
+//  per line, and writes the VictorOps json for every transition in them, one per line, exactly as the
+//  firmware sends them one by one.  The channel map is the firmware's own, so rebuild this after
+//  changing it.
+//
+//      compact_decode <device id> < payloads
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "../alarmsystem.ino"
+#include "compact_expand.h"
+
+static void print_json( const char *json, void *arg )
+{
+    (void) arg;
+    printf( "%s\n", json );
+}
+
+
+int main( int argc, char **argv )
+{
+    char line[ 2 * PUBLISH_DATA_MAX ];
+    int  status = 0;
+
+    if (argc != 2) {
+        fprintf( stderr, "usage: %s <device id> < payloads\n", argv[0] );
+        return( 2 );
+    }
+
+    channel_load_list( );
+    deviceId = argv[1];
+
+    while (fgets( line, sizeof( line ), stdin )) {
+
+        if (line[0] == '\n' || line[0] == 0) continue;
+
+        if (compact_expand( line, print_json, NULL ) < 0) {
+            fprintf( stderr, "not a compact batch: %s", line );
+            status = 1;
+        }
+    }
+
+    return( status );
+}
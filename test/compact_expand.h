@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------------------------------------
+//  compact_expand.h
+//
+//  Turns a compact access_changed payload back into the VictorOps json the firmware would have sent
+//  for each transition without USE_COMPACT_EVENTS.  Include after alarmsystem.ino, it uses the zone
+//  table and the event key prefix from there.  free_memory isn't in a compact batch, the expanded
+//  messages carry whatever System.freeMemory() says where they are expanded.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#ifndef _compact_expand_h_
+#define _compact_expand_h_
+
+typedef void (*CompactExpandHandler)( const char *json, void *arg );
+
+struct CompactExpand {
+    CompactExpandHandler handler;
+    void                *arg;
+};
+
+static void compact_expand_record( unsigned long sequence, unsigned long time, int channel, int severity,
+                                   uint64_t stateBits, void *arg )
+{
+    CompactExpand *expand = (CompactExpand *) arg;
+
+    if (channel >= TOTAL_CHANNELS || severity >= SEVERITY_COUNT) return;
+
+    CxString json = zoneTable[ channel ]->format_victorops_json( (int)((stateBits >> channel) & 1), time, sequence,
+                                                                 format_event_key( sequence ).data(),
+                                                                 severityNames[ severity ] );
+    expand->handler( json.data(), expand->arg );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// compact_expand
+//
+// payload is either the whole access_changed json or just its base64 "data".  Returns the number of
+// transitions expanded, or -1 if the batch doesn't decode.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static int compact_expand( const char *payload, CompactExpandHandler handler, void *arg )
+{
+    char          data[ PUBLISH_DATA_MAX + 1 ];
+    const char   *start = strstr( payload, "\"data\":\"" );
+    CompactExpand expand;
+
+    start = start ? start + strlen( "\"data\":\"" ) : payload;
+
+    int length = 0;
+    while (start[ length ] && start[ length ] != '"' && start[ length ] != '\n' && length < PUBLISH_DATA_MAX) {
+        data[ length ] = start[ length ];
+        length++;
+    }
+    data[ length ] = 0;
+
+    expand.handler = handler;
+    expand.arg     = arg;
+
+    return( CxEventCodec::decode( data, compact_expand_record, &expand ));
+}
+
+
+#endif
@@ -0,0 +1,224 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxarming_test.cpp
+//
+//  Host test for CxArming.  Walks the exit and entry countdowns a millisecond either side of their
+//  deadlines, checks which zones each mode watches, and that the mode survives a restart in EEPROM.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxarming.h>
+#include "check.h"
+
+#define FRONT_DOOR   0                      // perimeter, entry 30 s, exit 60 s
+#define BACK_DOOR    1                      // perimeter, entry 10 s, exit 30 s
+#define WINDOW       2                      // perimeter, instant
+#define MOTION       3                      // interior, instant unless an entry countdown is running
+
+#define BIT( c )     (1ULL << (c))
+
+static void setup_zones( CxArming& arming )
+{
+    arming.configure( BIT( FRONT_DOOR ) | BIT( BACK_DOOR ) | BIT( WINDOW ), BIT( MOTION ));
+    arming.setDelays( FRONT_DOOR, 30, 60 );
+    arming.setDelays( BACK_DOOR,  10, 30 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_exit_countdown
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_exit_countdown( void )
+{
+    CxArming      arming;
+    unsigned long t = 5000000;
+
+    setup_zones( arming );
+    arming.setMode( ARM_AWAY, t );
+
+    // leaving by either door is quiet, a window is not
+
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( BACK_DOOR ), t + 1000 ) == 0 );
+    CHECK( arming.entryBits() == 0 );
+    CHECK( arming.evaluate( BIT( WINDOW ), t + 1000 ) == BIT( WINDOW ));
+
+    // the back door's exit delay runs out first and it starts the entry countdown instead
+
+    CHECK( arming.evaluate( BIT( BACK_DOOR ), t + 29999 ) == 0 );
+    CHECK( arming.entryBits() == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), t + 30000 ) == 0 );
+    CHECK( arming.entryBits() == 0 );
+    CHECK( arming.evaluate( BIT( BACK_DOOR ), t + 30000 ) == 0 );
+    CHECK( arming.entryBits() == BIT( BACK_DOOR ));
+
+    // re-arming restarts every exit delay and drops the entry countdown
+
+    arming.setMode( ARM_AWAY, t + 31000 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( BACK_DOOR ), t + 31000 + 29999 ) == 0 );
+    CHECK( arming.entryBits() == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( BACK_DOOR ), t + 31000 + 30000 ) == 0 );
+    CHECK( arming.entryBits() == BIT( BACK_DOOR ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_entry_countdown
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_entry_countdown( void )
+{
+    CxArming      arming;
+    unsigned long t = 5000000;
+
+    setup_zones( arming );
+    arming.setMode( ARM_AWAY, t );
+    CHECK( arming.evaluate( 0, t + 60000 ) == 0 );
+
+    // coming in the front door, the motion sensor waits with it, a window doesn't
+
+    unsigned long entry = t + 120000;
+
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), entry ) == 0 );
+    CHECK( arming.entryBits() == BIT( FRONT_DOOR ));
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( MOTION ), entry + 1000 ) == 0 );
+    CHECK( arming.entryBits() == (BIT( FRONT_DOOR ) | BIT( MOTION )));
+    CHECK( arming.evaluate( BIT( MOTION ) | BIT( WINDOW ), entry + 2000 ) == BIT( WINDOW ));
+
+    // the back door opening later doesn't shorten the countdown already running
+
+    CHECK( arming.evaluate( BIT( BACK_DOOR ), entry + 20000 ) == 0 );
+    CHECK( arming.evaluate( BIT( MOTION ), entry + 29999 ) == 0 );
+
+    // when it runs out both doors are latched, shut or not
+
+    uint64_t doors = BIT( FRONT_DOOR ) | BIT( BACK_DOOR );
+
+    CHECK( arming.evaluate( BIT( MOTION ), entry + 30000 ) == (BIT( MOTION ) | doors ));
+    CHECK( arming.entryBits() == 0 );
+    CHECK( arming.latchedBits() == doors );
+    CHECK( arming.evaluate( 0, entry + 31000 ) == doors );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), entry + 32000 ) == doors );
+
+    // a mode change other than disarming keeps them latched
+
+    arming.setMode( ARM_STAY, entry + 35000 );
+    CHECK( arming.evaluate( 0, entry + 35000 ) == doors );
+
+    arming.setMode( ARM_DISARMED, entry + 40000 );
+    CHECK( arming.latchedBits() == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( MOTION ) | BIT( WINDOW ), entry + 40000 ) == 0 );
+
+    // both doors together use the shorter delay
+
+    arming.setMode( ARM_AWAY, t );
+    CHECK( arming.evaluate( 0, t + 60000 ) == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ) | BIT( BACK_DOOR ), entry ) == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), entry + 9999 ) == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), entry + 10000 ) == doors );
+    arming.setMode( ARM_DISARMED, entry + 11000 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_entry_shut_behind
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_entry_shut_behind( void )
+{
+    CxArming      arming;
+    unsigned long t     = 5000000;
+    unsigned long entry = t + 120000;
+
+    setup_zones( arming );
+    arming.setMode( ARM_AWAY, t );
+    CHECK( arming.evaluate( 0, t + 60000 ) == 0 );
+
+    // in through the front door and shut it, nobody disarms
+
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), entry ) == 0 );
+    CHECK( arming.evaluate( 0, entry + 2000 ) == 0 );
+    CHECK( arming.evaluate( 0, entry + 29999 ) == 0 );
+    CHECK( arming.evaluate( 0, entry + 30000 ) == BIT( FRONT_DOOR ));
+    CHECK( arming.evaluate( 0, entry + 600000 ) == BIT( FRONT_DOOR ));
+
+    // disarming in time latches nothing
+
+    arming.setMode( ARM_DISARMED, entry + 700000 );
+    CHECK( arming.evaluate( 0, entry + 700000 ) == 0 );
+
+    arming.setMode( ARM_AWAY, t + 1000000 );
+    CHECK( arming.evaluate( 0, t + 1060000 ) == 0 );
+    CHECK( arming.evaluate( BIT( FRONT_DOOR ), t + 1100000 ) == 0 );
+    CHECK( arming.evaluate( 0, t + 1102000 ) == 0 );
+    arming.setMode( ARM_DISARMED, t + 1110000 );
+    CHECK( arming.evaluate( 0, t + 1200000 ) == 0 );
+    CHECK( arming.latchedBits() == 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_modes
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_modes( void )
+{
+    CxArming      arming;
+    unsigned long t = 5000000;
+
+    setup_zones( arming );
+
+    // stay leaves the interior alone
+
+    arming.setMode( ARM_STAY, t );
+    CHECK( arming.evaluate( BIT( MOTION ), t + 100000 ) == 0 );
+    CHECK( arming.evaluate( BIT( WINDOW ), t + 100000 ) == BIT( WINDOW ));
+
+    // bypassed zones never alarm, whoever bypassed them
+
+    arming.setBypass( WINDOW, TRUE );
+    CHECK( arming.evaluate( BIT( WINDOW ), t + 100000 ) == 0 );
+    arming.setBypass( WINDOW, FALSE );
+    arming.setScheduledBypass( BIT( WINDOW ));
+    CHECK( arming.evaluate( BIT( WINDOW ), t + 100000 ) == 0 );
+    CHECK( arming.bypassBits() == BIT( WINDOW ));
+
+    CHECK( !arming.setMode( ARM_MODES, t ));
+    CHECK( arming.mode() == ARM_STAY );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_restore
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_restore( void )
+{
+    EEPROM.clear( );
+
+    CxArming fresh;
+    CHECK( fresh.restore( ARM_AWAY ) == ARM_AWAY );
+
+    fresh.setMode( ARM_STAY, 0 );
+
+    CxArming restarted;
+    CHECK( restarted.restore( ARM_AWAY ) == ARM_STAY );
+    CHECK( restarted.mode() == ARM_STAY );
+}
+
+
+int main( void )
+{
+    test_exit_countdown( );
+    test_entry_countdown( );
+    test_entry_shut_behind( );
+    test_modes( );
+    test_restore( );
+
+    return( check_report( "cxarming" ));
+}
@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxchaintest_test.cpp
+//
+//  Host test for CxChainTest against the simulated 165 chain.  A healthy chain passes whatever the
+//  zones read, every zone closed included, and a data line stuck low is reported STUCK and leaves the
+//  chain on the stock delay.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxchaintest.h>
+#include "host.h"
+#include "check.h"
+
+#define CHAIN_BITS  48
+
+static SN74HC165N  chain;
+static CxChainTest chainTest;
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_healthy
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_healthy( void )
+{
+    static const uint64_t inputs[] = { 0, 0xFFFFFFFFFFFFULL, 0x000000000102ULL, 0x800000000001ULL };
+
+    for (unsigned int i = 0; i < sizeof( inputs ) / sizeof( inputs[0] ); i++) {
+
+        host_set_inputs( inputs[ i ] );
+
+        CHECK( chainTest.run( &chain, CHAIN_BITS ) == CHAIN_OK );
+        CHECK( chainTest.inputDelay() <= SN74HC165N_DEFAULT_DELAY_US );
+        CHECK( chain.readChain( CHAIN_BITS ) == inputs[ i ] );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_stuck
+//
+// stuck low reads the same as every zone closed, the bits past the end are what give it away.  Stuck
+// high reads as every zone open, the relay trips on that without the self test
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_stuck( void )
+{
+    host_set_inputs( 0 );
+
+    host_stick_input( LOW );
+    CHECK( chain.readChain( CHAIN_BITS ) == 0 );
+    CHECK( chainTest.run( &chain, CHAIN_BITS ) == CHAIN_STUCK );
+    CHECK( strcmp( CxChainTest::faultName( chainTest.fault() ), "STUCK" ) == 0 );
+    CHECK( chainTest.inputDelay() == SN74HC165N_DEFAULT_DELAY_US );
+
+    host_stick_input( HIGH );
+    CHECK( chain.readChain( CHAIN_BITS ) == 0xFFFFFFFFFFFFULL );
+
+    host_stick_input( -1 );
+    CHECK( chainTest.run( &chain, CHAIN_BITS ) == CHAIN_OK );
+}
+
+
+int main( void )
+{
+    host_input_chain( D2, D0, D3, CHAIN_BITS, CHAIN_SERIAL_LEVEL );
+    chain.begin( D2, D1, D0, D3 );
+
+    test_healthy( );
+    test_stuck( );
+
+    return( check_report( "cxchaintest" ));
+}
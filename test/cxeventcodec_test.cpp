@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxeventcodec_test.cpp
+//
+//  Host test for CxEventCodec.  A batch is filled until it refuses a record, encoded, decoded, and 
+//  every record has to come back with the sequence, time, channel, severity and zone state it went in
+//  with.  Sequence gaps, the clock stepping backwards and several transitions with the same time are
+//  all in the mix.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxeventcodec.h>
+#include <string.h>
+#include "check.h"
+
+#define RECORDS_MAX 200
+
+struct Record {
+    unsigned long sequence;
+    unsigned long time;
+    int           channel;
+    int           severity;
+    uint64_t      state;
+};
+
+static Record expected[ RECORDS_MAX ];
+static int    decoded;
+
+static void record( unsigned long sequence, unsigned long time, int channel, int severity, uint64_t stateBits, void *arg )
+{
+    (void) arg;
+
+    if (decoded < RECORDS_MAX) {
+        CHECK( sequence  == expected[ decoded ].sequence );
+        CHECK( time      == expected[ decoded ].time );
+        CHECK( channel   == expected[ decoded ].channel );
+        CHECK( severity  == expected[ decoded ].severity );
+        CHECK( stateBits == expected[ decoded ].state );
+    }
+    decoded++;
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_round_trip
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_round_trip( void )
+{
+    CxEventCodec  codec;
+    uint64_t      state    = 0x0000A5A5F00FULL;
+    unsigned long sequence = 4000000000UL;                  // wraps partway through the batch
+    unsigned long time     = 1700000000UL;
+    int           records  = 0;
+
+    while (records < RECORDS_MAX) {
+
+        int channel  = (records * 7) % EVENT_CODEC_CHANNELS;
+        int severity = records % EVENT_CODEC_SEVERITIES;
+
+        if (!codec.append( sequence, time, state, channel, severity )) break;
+
+        state ^= 1ULL << channel;
+
+        expected[ records ].sequence = sequence;
+        expected[ records ].time     = time;
+        expected[ records ].channel  = channel;
+        expected[ records ].severity = severity;
+        expected[ records ].state    = state;
+        records++;
+
+        sequence += 1 + (records % 3) * 100000000UL;
+        time     += (records % 4 == 3) ? -3600 : (records % 4) * 7;
+    }
+
+    CHECK( records > 10 );
+    CHECK( records < RECORDS_MAX );
+    CHECK( codec.entries() == records );
+    CHECK( codec.lastSequence() == expected[ records - 1 ].sequence );
+
+    char text[ 700 ];
+    int  length = codec.encode( text, sizeof( text ));
+
+    CHECK( length > 0 );
+    CHECK( length == (int) strlen( text ));
+
+    decoded = 0;
+    CHECK( CxEventCodec::decode( text, record, NULL ) == records );
+    CHECK( decoded == records );
+
+    // the text has to fit where it is going
+
+    CHECK( codec.encode( text, 16 ) == -1 );
+
+    codec.reset( );
+    CHECK( codec.entries() == 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_bad_input
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_bad_input( void )
+{
+    CxEventCodec codec;
+    char         text[ 64 ];
+
+    codec.append( 10, 1000, 0, 0, 3 );
+    codec.append( 11, 1000, 0, 1, 3 );
+    codec.append( 13, 1005, 0, 0, 0 );
+    codec.encode( text, sizeof( text ));
+
+    decoded = 0;
+    expected[0].sequence = 10; expected[0].time = 1000; expected[0].channel = 0; expected[0].severity = 3; expected[0].state = 0x1;
+    expected[1].sequence = 11; expected[1].time = 1000; expected[1].channel = 1; expected[1].severity = 3; expected[1].state = 0x3;
+    expected[2].sequence = 13; expected[2].time = 1005; expected[2].channel = 0; expected[2].severity = 0; expected[2].state = 0x2;
+    CHECK( CxEventCodec::decode( text, record, NULL ) == 3 );
+
+    // a channel or severity that can't be carried is refused
+
+    CHECK( !codec.append( 14, 1005, 0, EVENT_CODEC_CHANNELS, 0 ));
+    CHECK( !codec.append( 14, 1005, 0, 0, EVENT_CODEC_SEVERITIES ));
+    CHECK( codec.entries() == 3 );
+
+    // cut short in the middle of the last record
+
+    text[ strlen( text ) - 2 ] = 0;
+    CHECK( CxEventCodec::decode( text, NULL, NULL ) == -1 );
+
+    CHECK( CxEventCodec::decode( "not base64!", NULL, NULL ) == -1 );
+    CHECK( CxEventCodec::decode( "", NULL, NULL ) == -1 );
+}
+
+
+int main( void )
+{
+    test_round_trip( );
+    test_bad_input( );
+
+    return( check_report( "cxeventcodec" ));
+}
@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxhistory_bench.cpp
+//
+//  Benchmark for CxHistory.  Fills the ring past wrapping with three kinds of activity and reports how
+//  many transitions it holds, the bytes each one takes against a plain 8 byte record (uint32 time,
+//  channel, state and padding), and how long last() takes for all zones and for one zone.  A query
+//  for one zone still decodes every block, so its time follows the ring size, not the answer size.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxhistory.h>
+#include <string.h>
+#include "check.h"
+#include "bench.h"
+
+#define PLAIN_RECORD_BYTES  8
+#define QUERY_REPEATS       2000
+#define FILL_TRANSITIONS    20000
+
+static unsigned long randomState = 1;
+
+static unsigned long next_random( void )
+{
+    randomState = randomState * 1103515245UL + 12345UL;
+    return( (randomState >> 16) & 0x7FFF );
+}
+
+static void count_one( unsigned long time, int channel, int activated, void *arg )
+{
+    (void) time;
+    (void) channel;
+    (void) activated;
+    (*(int *) arg)++;
+}
+
+static CxHistory history;
+
+
+//------------------------------------------------------------------------------------------------------------
+// fill
+//
+// busy is a household during the day, a few doors seconds to minutes apart.  sparse is a quiet house,
+// hours between transitions.  burst is a window left to bounce, the same zone a second apart.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void fill( const char *kind )
+{
+    unsigned long time  = 1700000000UL;
+    uint64_t      state = 0;
+
+    history.clear( );
+
+    for (int i = 0; i < FILL_TRANSITIONS; i++) {
+
+        int channel;
+
+        if (strcmp( kind, "busy" ) == 0) {
+            channel = next_random() % 6;
+            time   += 5 + next_random() % 300;
+        } else if (strcmp( kind, "sparse" ) == 0) {
+            channel = next_random() % 26;
+            time   += 3600 + next_random() % 14400;
+        } else {
+            channel = 1;
+            time   += 1;
+        }
+
+        state ^= 1ULL << channel;
+        history.append( time, channel, (int)((state >> channel) & 1) );
+    }
+}
+
+
+static void bench_kind( const char *kind )
+{
+    char label[ 64 ];
+
+    fill( kind );
+
+    int held  = history.entries();
+    int bytes = history.bytesUsed();
+
+    printf( "%s: %d transitions held in %d bytes, %.2f bytes each, %.1fx smaller than plain records\n",
+            kind, held, bytes, (double) bytes / held, (double)( held * PLAIN_RECORD_BYTES ) / bytes );
+
+    CHECK( held > 0 );
+    CHECK( bytes <= HISTORY_BLOCKS * HISTORY_BLOCK_BYTES );
+
+    static const int counts[] = { 10, 100, 1000000 };
+
+    for (unsigned int c = 0; c < sizeof( counts ) / sizeof( counts[0] ); c++) {
+
+        int handed = 0;
+
+        double start = bench_seconds();
+        for (int r = 0; r < QUERY_REPEATS; r++) {
+            history.last( counts[ c ], HISTORY_ALL_ZONES, count_one, &handed );
+        }
+        double took = bench_seconds() - start;
+
+        int expected = counts[ c ] < held ? counts[ c ] : held;
+        CHECK( handed == expected * QUERY_REPEATS );
+
+        snprintf( label, sizeof( label ), "last %d, all zones", expected );
+        bench_report( label, took, QUERY_REPEATS );
+    }
+
+    int handed = 0;
+
+    double start = bench_seconds();
+    for (int r = 0; r < QUERY_REPEATS; r++) {
+        history.last( 10, 1, count_one, &handed );
+    }
+    double took = bench_seconds() - start;
+
+    CHECK( handed > 0 );
+    bench_report( "last 10, one zone", took, QUERY_REPEATS );
+}
+
+
+int main( void )
+{
+    bench_kind( "busy" );
+    bench_kind( "sparse" );
+    bench_kind( "burst" );
+
+    return( check_report( "cxhistory_bench" ));
+}
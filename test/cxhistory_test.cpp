@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxhistory_test.cpp
+//
+//  Host test for CxHistory.  Far more transitions go in than the blocks can hold, so the ring wraps
+//  many times over, and whatever is still held has to be exactly the newest part of a plain list of
+//  everything that was appended.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxhistory.h>
+#include <string.h>
+#include "check.h"
+
+#define REFERENCE_MAX 6000
+
+struct Transition {
+    unsigned long time;
+    int           channel;
+    int           activated;
+};
+
+static Transition reference[ REFERENCE_MAX ];
+static int        referenceCount;
+
+static Transition handed[ REFERENCE_MAX ];
+static int        handedCount;
+
+static unsigned long randomState = 1;
+
+static unsigned long next_random( void )
+{
+    randomState = randomState * 1103515245UL + 12345UL;
+    return( (randomState >> 16) & 0x7FFF );
+}
+
+static void collect( unsigned long time, int channel, int activated, void *arg )
+{
+    (void) arg;
+
+    if (handedCount < REFERENCE_MAX) {
+        handed[ handedCount ].time      = time;
+        handed[ handedCount ].channel   = channel;
+        handed[ handedCount ].activated = activated;
+    }
+    handedCount++;
+}
+
+//
+// the handed over transitions have to be the newest count entries of the reference for the channel
+//
+static int matches_reference( int count, int channel )
+{
+    int r = referenceCount;
+    int h = count;
+
+    while (h > 0 && r > 0) {
+        r--;
+        if (channel != HISTORY_ALL_ZONES && reference[ r ].channel != channel) continue;
+        h--;
+        if (handed[ h ].time      != reference[ r ].time)      return( FALSE );
+        if (handed[ h ].channel   != reference[ r ].channel)   return( FALSE );
+        if (handed[ h ].activated != reference[ r ].activated) return( FALSE );
+    }
+
+    return( h == 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_wraparound
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_wraparound( void )
+{
+    static CxHistory history;
+    unsigned long    time = 1700000000UL;
+    int              highWater = 0;
+
+    referenceCount = 0;
+
+    for (int i = 0; i < REFERENCE_MAX; i++) {
+
+        // mostly bursts a few seconds apart with the odd long gap, and the clock stepping back once
+
+        time += (next_random() % 3 == 0) ? next_random() % 5 : next_random() % 4000;
+        if (i == 100) time -= 3600;
+        if (i == 3000) time += 90000000UL;
+
+        int channel   = next_random() % 48;
+        int activated = next_random() % 2;
+
+        history.append( time, channel, activated );
+
+        reference[ referenceCount ].time      = time;
+        reference[ referenceCount ].channel   = channel;
+        reference[ referenceCount ].activated = activated;
+        referenceCount++;
+
+        if (history.entries() > highWater) highWater = history.entries();
+    }
+
+    // the ring filled and has been dropping its oldest block since
+
+    CHECK( highWater < REFERENCE_MAX / 2 );
+    CHECK( history.entries() > 0 );
+    CHECK( history.entries() < highWater );
+    CHECK( history.bytesUsed() <= HISTORY_BLOCKS * HISTORY_BLOCK_BYTES );
+
+    handedCount = 0;
+    CHECK( history.last( 30, HISTORY_ALL_ZONES, collect, NULL ) == 30 );
+    CHECK( handedCount == 30 );
+    CHECK( matches_reference( 30, HISTORY_ALL_ZONES ));
+
+    // everything held, which spans several blocks and the block being filled
+
+    int held = history.entries();
+
+    handedCount = 0;
+    CHECK( history.last( REFERENCE_MAX, HISTORY_ALL_ZONES, collect, NULL ) == held );
+    CHECK( handedCount == held );
+    CHECK( matches_reference( held, HISTORY_ALL_ZONES ));
+
+    // one zone only
+
+    handedCount = 0;
+    int zone = history.last( 10, 7, collect, NULL );
+    CHECK( zone == 10 );
+    CHECK( handedCount == zone );
+    CHECK( matches_reference( zone, 7 ));
+
+    history.clear( );
+    CHECK( history.entries() == 0 );
+    CHECK( history.last( 10, HISTORY_ALL_ZONES, collect, NULL ) == 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_time_backwards
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_time_backwards( void )
+{
+    CxHistory history;
+
+    history.append( 5000, 1, 1 );
+    history.append( 3000, 2, 0 );
+    history.append( 3000, 3, 1 );
+
+    handedCount = 0;
+    CHECK( history.last( 5, HISTORY_ALL_ZONES, collect, NULL ) == 3 );
+    CHECK( handed[ 0 ].time == 5000 && handed[ 0 ].channel == 1 && handed[ 0 ].activated == 1 );
+    CHECK( handed[ 1 ].time == 3000 && handed[ 1 ].channel == 2 && handed[ 1 ].activated == 0 );
+    CHECK( handed[ 2 ].time == 3000 && handed[ 2 ].channel == 3 && handed[ 2 ].activated == 1 );
+}
+
+
+int main( void )
+{
+    test_wraparound( );
+    test_time_backwards( );
+
+    return( check_report( "cxhistory" ));
+}
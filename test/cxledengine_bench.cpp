@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxledengine_bench.cpp
+//
+//  Benchmark for CxLedEngine.  The engine runs off its timer on the simulated Photon with a 595 chain
+//  that nothing hangs off, so a frame costs render() and shiftPlane() and the pin writes, not a model
+//  of the LED's.  On the host micros() only moves with the simulated clock, so frameMicros() reads
+//  nothing here.  The figures are wall clock instead: the same run of simulated milliseconds is timed
+//  with and without the engine's timer and the difference is shared out over the ticks and the planes
+//  shifted.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxledengine.h>
+#include "host.h"
+#include "check.h"
+#include "bench.h"
+
+#define BENCH_MS   20000                    // ten cycles of every pattern
+
+static SN74HC595   chain( D6, D5, D4 );
+static CxLedEngine engine( &chain );
+
+static double run_millis( void )
+{
+    double start = bench_seconds();
+    host_advance( BENCH_MS );
+    return( bench_seconds() - start );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// bench_patterns
+//
+// quiet is every LED steady, the chain only goes out on the refresh.  house is the alarm panel on a
+// busy day, a few zones blinking and the rest dim.  worst has every LED at a different level and
+// pattern so nearly every plane differs from the one before it.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void bench_patterns( const char *kind, double baseline )
+{
+    for (int led = 0; led < LED_COUNT; led++) {
+
+        if (strcmp( kind, "quiet" ) == 0) {
+            engine.setPattern( led, LED_STEADY );
+            engine.setBrightness( led, LED_MAX_LEVEL );
+        } else if (strcmp( kind, "house" ) == 0) {
+            engine.setPattern( led, (led % 12 == 0) ? LED_SLOW_BLINK : (led == 5) ? LED_FAST_BLINK : LED_DIM );
+            engine.setBrightness( led, LED_MAX_LEVEL );
+        } else {
+            engine.setPattern( led, LED_STEADY + led % (LED_PATTERNS - LED_STEADY) );
+            engine.setBrightness( led, 1 + led % LED_MAX_LEVEL );
+        }
+    }
+
+    unsigned long shifts = engine.shifts();
+    double        took   = run_millis() - baseline;
+
+    shifts = engine.shifts() - shifts;
+
+    printf( "%s: %lu planes shifted in %d ms\n", kind, shifts, BENCH_MS );
+
+    bench_report( "tick", took, BENCH_MS / LED_TICK_MS );
+    bench_report( "ticks shared over the planes shifted", took, shifts );
+
+    CHECK( shifts > 0 );
+    CHECK( shifts <= (unsigned long)( BENCH_MS / LED_TICK_MS ));
+}
+
+
+int main( void )
+{
+    // the simulated clock on its own, before the engine's timer is running
+
+    double baseline = run_millis();
+
+    engine.begin( );
+    host_advance( LED_REFRESH_MS );
+
+    bench_patterns( "quiet", baseline );
+    bench_patterns( "house", baseline );
+    bench_patterns( "worst", baseline );
+
+    benchSink = engine.shifts();
+
+    return( check_report( "cxledengine_bench" ));
+}
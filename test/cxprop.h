@@ -0,0 +1,7 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxprop.h
+//
+//  The firmware includes cxprop.h, which isn't part of this repository and nothing from it is used.
+//  This empty stand-in lets the host tests build the firmware.
+//
+//------------------------------------------------------------------------------------------------------------
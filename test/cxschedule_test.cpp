@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxschedule_test.cpp
+//
+//  Host test for CxSchedule in US Mountain time.  Rules that run past local midnight, and past the
+//  end of the week, are checked at the minutes around their edges, then every minute of the weeks
+//  around both daylight saving changes is compared with a reference worked out here from the
+//  known UTC instants of the 2024 changes.  The schedule is only evaluated when due() says so, as
+//  the firmware does.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxschedule.h>
+#include "check.h"
+
+#define MOUNTAIN_STANDARD  (-7 * 3600L)
+
+#define DST_START_2024     1710061200UL     // 2024-03-10 09:00 UTC, 2am MST
+#define DST_END_2024       1730620800UL     // 2024-11-03 08:00 UTC, 2am MDT
+#define SUNDAY_MARCH_3     1709449200UL     // 2024-03-03 00:00 MST
+#define SUNDAY_OCTOBER_27  1730008800UL     // 2024-10-27 00:00 MDT
+#define FRIDAY_MARCH_15    1710565200UL     // 2024-03-15 23:00 MDT
+
+#define GARAGE     0x1                      // weekdays 08:00 - 18:00
+#define OVERNIGHT  0x2                      // Friday and Saturday 22:00 - 06:00 the next day
+#define SUNDAY     0x4                      // all day Sunday
+
+static void setup_rules( CxSchedule& schedule )
+{
+    schedule.setTimeZone( MOUNTAIN_STANDARD, TRUE );
+    schedule.addRule( GARAGE,    SCHEDULE_WEEKDAYS, 8 * 60, 18 * 60 );
+    schedule.addRule( OVERNIGHT, SCHEDULE_FRIDAY | SCHEDULE_SATURDAY, 22 * 60, 6 * 60 );
+    schedule.addRule( SUNDAY,    SCHEDULE_SUNDAY, 0, 0 );
+}
+
+//
+// the zones the rules above cover at a UTC time, worked out without CxSchedule
+//
+static uint64_t expected( unsigned long now )
+{
+    long offset = MOUNTAIN_STANDARD;
+    if (now >= DST_START_2024 && now < DST_END_2024) offset += 3600;
+
+    unsigned long local   = now + offset;
+    int           weekday = (int)((local / 86400 + 4) % 7);     // 1970-01-01 was a Thursday
+    int           minute  = (int)((local % 86400) / 60);
+    uint64_t      bits    = 0;
+
+    if (weekday >= 1 && weekday <= 5 && minute >= 8 * 60 && minute < 18 * 60) bits |= GARAGE;
+    if ((weekday == 5 || weekday == 6) && minute >= 22 * 60) bits |= OVERNIGHT;
+    if ((weekday == 6 || weekday == 0) && minute < 6 * 60) bits |= OVERNIGHT;
+    if (weekday == 0) bits |= SUNDAY;
+
+    return( bits );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_midnight
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_midnight( void )
+{
+    CxSchedule schedule;
+
+    setup_rules( schedule );
+    CHECK( schedule.compile() > 0 );
+
+    // Friday night into Saturday morning
+
+    unsigned long friday = FRIDAY_MARCH_15;
+
+    CHECK( schedule.evaluate( friday - 3600 - 60 ) == 0 );                        // 21:59
+    CHECK( schedule.evaluate( friday - 3600 ) == OVERNIGHT );               // 22:00
+    CHECK( schedule.evaluate( friday + 3540 ) == OVERNIGHT );               // 23:59
+    CHECK( schedule.evaluate( friday + 3600 ) == OVERNIGHT );               // Saturday 00:00
+    CHECK( schedule.evaluate( friday + 7 * 3600 - 60 ) == OVERNIGHT );      // 05:59
+    CHECK( schedule.evaluate( friday + 7 * 3600 ) == 0 );                   // 06:00
+
+    // Saturday night runs past the end of the week into Sunday, which has its own rule
+
+    unsigned long saturday = friday + 86400;
+
+    CHECK( schedule.evaluate( saturday + 3540 ) == OVERNIGHT );             // Saturday 23:59
+    CHECK( schedule.evaluate( saturday + 3600 ) == (OVERNIGHT | SUNDAY) );  // Sunday 00:00
+    CHECK( schedule.evaluate( saturday + 7 * 3600 ) == SUNDAY );            // Sunday 06:00
+    CHECK( schedule.evaluate( saturday + 86400 + 3540 ) == SUNDAY );        // Sunday 23:59
+    CHECK( schedule.evaluate( saturday + 86400 + 3600 ) == 0 );             // Monday 00:00
+
+    // the Saturday night change is due no later than the top of the hour it falls in
+
+    schedule.evaluate( saturday + 3000 );
+    CHECK( schedule.nextCheck() == saturday + 3600 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_daylight_saving
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_daylight_saving( void )
+{
+    CHECK( !CxSchedule::isUSDaylightTime( DST_START_2024 - 1, MOUNTAIN_STANDARD ));
+    CHECK(  CxSchedule::isUSDaylightTime( DST_START_2024, MOUNTAIN_STANDARD ));
+    CHECK(  CxSchedule::isUSDaylightTime( DST_END_2024 - 1, MOUNTAIN_STANDARD ));
+    CHECK( !CxSchedule::isUSDaylightTime( DST_END_2024, MOUNTAIN_STANDARD ));
+
+    unsigned long weeks[ 2 ] = { SUNDAY_MARCH_3, SUNDAY_OCTOBER_27 };
+
+    for (int w = 0; w < 2; w++) {
+
+        CxSchedule schedule;
+
+        setup_rules( schedule );
+        schedule.compile( );
+
+        int evaluations = 0;
+        int mismatches  = 0;
+
+        for (unsigned long now = weeks[ w ]; now < weeks[ w ] + 21 * 86400UL; now += 60) {
+
+            if (schedule.due( now )) {
+                schedule.evaluate( now );
+                evaluations++;
+            }
+
+            if (schedule.current() != expected( now )) mismatches++;
+        }
+
+        CHECK( mismatches == 0 );
+        CHECK( evaluations <= 21 * 24 + 40 );
+    }
+}
+
+
+int main( void )
+{
+    test_midnight( );
+    test_daylight_saving( );
+
+    return( check_report( "cxschedule" ));
+}
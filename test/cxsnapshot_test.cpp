@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxsnapshot_test.cpp
+//
+//  Host test for CxZoneSnapshot.  A snapshot has to survive format / parse with all 64 bits intact,
+//  reconcile has to name exactly the zones whose open state differs, and an older snapshot has to
+//  be refused.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxsnapshot.h>
+#include <string.h>
+#include "check.h"
+
+static int critical[ 64 ];
+static int recovery[ 64 ];
+
+static void action( int channel, int action, void *arg )
+{
+    (void) arg;
+
+    if (action == SNAPSHOT_ACTION_CRITICAL) critical[ channel ]++;
+    if (action == SNAPSHOT_ACTION_RECOVERY) recovery[ channel ]++;
+}
+
+static void clear_actions( void )
+{
+    memset( critical, 0, sizeof( critical ));
+    memset( recovery, 0, sizeof( recovery ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_format_parse
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_format_parse( void )
+{
+    CxZoneSnapshot snapshot( 0x8000FFFFFFFFFFFFULL, 0x8000000100000006ULL, 4294967295UL );
+    char           json[ 128 ];
+
+    int length = snapshot.format( json, sizeof( json ));
+    CHECK( length == (int) strlen( json ));
+    CHECK( strcmp( json, "\"configured\":\"8000ffffffffffff\",\"activated\":\"8000000100000006\","
+                         "\"last_seq\":4294967295" ) == 0 );
+
+    // the fields are picked out of a larger payload
+
+    char payload[ 192 ];
+    snprintf( payload, sizeof( payload ), "{\"uptime\":12,%s,\"rssi\":-60}", json );
+
+    CxZoneSnapshot parsed;
+    CHECK( parsed.parse( payload ));
+    CHECK( parsed.configuredBits == snapshot.configuredBits );
+    CHECK( parsed.activatedBits  == snapshot.activatedBits );
+    CHECK( parsed.sequence       == snapshot.sequence );
+
+    CxZoneSnapshot empty( 0, 0, 0 );
+    empty.format( json, sizeof( json ));
+    CHECK( strcmp( json, "\"configured\":\"0\",\"activated\":\"0\",\"last_seq\":0" ) == 0 );
+
+    // missing or malformed fields leave the snapshot alone
+
+    CHECK( !parsed.parse( "{\"configured\":\"ff\",\"last_seq\":3}" ));
+    CHECK( !parsed.parse( "{\"configured\":\"ff\",\"activated\":\"xy\",\"last_seq\":3}" ));
+    CHECK( !parsed.parse( "{\"configured\":\"11112222333344445\",\"activated\":\"1\",\"last_seq\":3}" ));
+    CHECK( !parsed.parse( "{\"configured\":\"ff\",\"activated\":\"1\"}" ));
+    CHECK( parsed.configuredBits == snapshot.configuredBits );
+    CHECK( parsed.sequence       == snapshot.sequence );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_reconcile
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_reconcile( void )
+{
+    // zone 0 opened, zone 2 closed, zone 5 was open and dropped out of the configuration, zone 6 is
+    // open but not configured either time, zone 63 opened
+
+    CxZoneSnapshot known(   0x000000000000002FULL, 0x0000000000000064ULL, 10 );
+    CxZoneSnapshot current( 0x800000000000000FULL, 0x8000000000000061ULL, 12 );
+
+    clear_actions( );
+    CHECK( CxZoneSnapshot::reconcile( known, current, action, NULL ) == 4 );
+
+    for (int c = 0; c < 64; c++) {
+        CHECK( critical[ c ] == ((c == 0 || c == 63) ? 1 : 0) );
+        CHECK( recovery[ c ] == ((c == 2 || c == 5)  ? 1 : 0) );
+    }
+
+    // nothing to do for the same state, even with a newer sequence
+
+    clear_actions( );
+    CHECK( CxZoneSnapshot::reconcile( current, current, action, NULL ) == 0 );
+
+    // an older snapshot is refused, also across a sequence wrap
+
+    CHECK( CxZoneSnapshot::reconcile( current, known, action, NULL ) == -1 );
+
+    CxZoneSnapshot beforeWrap( 0xF, 0x0, 4294967290UL );
+    CxZoneSnapshot afterWrap(  0xF, 0x1, 3 );
+
+    clear_actions( );
+    CHECK( CxZoneSnapshot::reconcile( beforeWrap, afterWrap, action, NULL ) == 1 );
+    CHECK( critical[ 0 ] == 1 );
+    CHECK( CxZoneSnapshot::reconcile( afterWrap, beforeWrap, action, NULL ) == -1 );
+}
+
+
+int main( void )
+{
+    test_format_parse( );
+    test_reconcile( );
+
+    return( check_report( "cxsnapshot" ));
+}
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtimerwheel_bench.cpp
+//
+//  Benchmark for CxTimerWheel with thousands of timers running, built with a raised
+//  TIMER_WHEEL_CAPACITY.  Times start, cancel and the advance that fires them with the timers spread
+//  over each level of the wheel, at several pool sizes.  Start, cancel and the cost per fired timer
+//  should stay flat as the count grows, that is the point of the wheel over a sorted list.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxtimerwheel.h>
+#include "check.h"
+#include "bench.h"
+
+static unsigned long fired;
+
+static void expired( void *arg )
+{
+    (void) arg;
+    fired++;
+}
+
+static CxTimerWheel  wheel;
+static CxTimerHandle handles[ TIMER_WHEEL_CAPACITY ];
+static unsigned long nowMillis;
+
+
+//------------------------------------------------------------------------------------------------------------
+// bench_timers
+//
+// Delays cycle through level 0, level 1 and level 2 distances so every advance cascades.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void bench_timers( int timers )
+{
+    static const unsigned long spans[] = { 2000, 150000, 9000000 };
+
+    printf( "%d timers\n", timers );
+
+    // start the timers then cancel them in a different order than they went in
+
+    double start = bench_seconds();
+    for (int i = 0; i < timers; i++) {
+        handles[ i ] = wheel.start( 1 + (i * 7919UL) % spans[ i % 3 ], expired, NULL );
+    }
+    double started = bench_seconds() - start;
+
+    CHECK( wheel.entries() == timers );
+
+    start = bench_seconds();
+    for (int i = 0; i < timers; i++) {
+        wheel.cancel( handles[ (i * 7) % timers ] );
+    }
+    double canceled = bench_seconds() - start;
+
+    CHECK( wheel.entries() == 0 );
+
+    bench_report( "start", started, timers );
+    bench_report( "cancel", canceled, timers );
+
+    // start them again and let the wheel run past the longest in 250ms steps like loop()
+
+    for (int i = 0; i < timers; i++) {
+        handles[ i ] = wheel.start( 1 + (i * 7919UL) % spans[ i % 3 ], expired, NULL );
+    }
+
+    // each step is timed on its own so the steps that fire something can be told from the empty ones
+
+    fired = 0;
+
+    double        firing = 0, empty = 0;
+    unsigned long emptySteps = 0;
+
+    for (unsigned long t = 0; t <= spans[ 2 ] + 1000; t += 250) {
+
+        nowMillis += 250;
+
+        double step = bench_seconds();
+        int    due  = wheel.advance( nowMillis );
+        step = bench_seconds() - step;
+
+        if (due) {
+            firing += step;
+        } else {
+            empty += step;
+            emptySteps++;
+        }
+    }
+
+    CHECK( fired == (unsigned long) timers );
+    CHECK( wheel.entries() == 0 );
+
+    bench_report( "advance, per fired timer", firing, fired );
+    bench_report( "advance, step with nothing due", empty, emptySteps );
+}
+
+
+int main( void )
+{
+    wheel.begin( nowMillis );
+
+    for (int timers = 256; timers <= TIMER_WHEEL_CAPACITY; timers *= 4) {
+        bench_timers( timers );
+    }
+
+    return( check_report( "cxtimerwheel_bench" ));
+}
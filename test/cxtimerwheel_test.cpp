@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxtimerwheel_test.cpp
+//
+//  Host test for CxTimerWheel.  Timers are started at distances that land them in each level of the
+//  wheel and past its span, then the wheel is stepped a few milliseconds at a time.  Every timer has
+//  to fire no earlier than its deadline and within two ticks after it, which only holds if nodes are
+//  re-filed correctly as the wheel cascades down the levels.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <cxtimerwheel.h>
+#include "check.h"
+
+#define TIMERS 64
+
+static unsigned long nowMillis;
+static unsigned long firedAt[ TIMERS ];
+static int           fired[ TIMERS ];
+
+static void expired( void *arg )
+{
+    int i = (int)(intptr_t) arg;
+
+    firedAt[ i ] = nowMillis;
+    fired[ i ]++;
+}
+
+static CxTimerWheel  *chainWheel;
+static CxTimerHandle  chained = TIMER_HANDLE_NONE;
+
+static void restart( void *arg )
+{
+    expired( arg );
+    chained = chainWheel->start( 500, expired, (void *)(intptr_t)( TIMERS - 1 ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// run_until
+//
+// Steps the wheel in 7ms increments, an odd step so ticks are crossed at every phase.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void run_until( CxTimerWheel *wheel, unsigned long start, unsigned long elapsed )
+{
+    for (unsigned long t=0; t<=elapsed; t+=7) {
+        nowMillis = start + t;
+        wheel->advance( nowMillis );
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_levels
+//
+// Level 0 covers 256 ticks (2.56s), level 1 a further 64 revolutions of that (164s) and level 2 64 
+// of those (2.9 hours).  The delays straddle each boundary and the start sits just before millis()
+// rolls over.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_levels( void )
+{
+    static const unsigned long delays[] = {
+        0, 1, 10, 11, 2550, 2560, 2570,                         // level 0 and its edge
+        30000, 163830, 163840, 163850,                          // level 1 and its edge
+        1000000, 10485750, 10485760,                            // level 2 up to the span
+        10500000, 25000000                                      // parked and re-filed
+    };
+    int count = sizeof( delays ) / sizeof( delays[0] );
+
+    CxTimerWheel  wheel;
+    CxTimerHandle handles[ TIMERS ];
+    unsigned long start = 0xFFFFFFFFUL - 60000;
+
+    memset( fired, 0, sizeof( fired ));
+
+    nowMillis = start;
+    wheel.begin( start );
+
+    for (int i=0; i<count; i++) {
+        handles[i] = wheel.start( delays[i], expired, (void *)(intptr_t) i );
+        CHECK( handles[i] != TIMER_HANDLE_NONE );
+    }
+
+    CHECK( wheel.entries() == count );
+
+    run_until( &wheel, start, 25000000 + 100 );
+
+    for (int i=0; i<count; i++) {
+
+        long late = (long)(firedAt[i] - start) - (long) delays[i];
+
+        CHECK( fired[i] == 1 );
+        CHECK( late >= 0 );
+        CHECK( late <= 2 * TIMER_WHEEL_TICK_MS + 7 );
+
+        // a fired timer's handle is stale
+
+        CHECK( !wheel.pending( handles[i] ));
+        CHECK( !wheel.cancel( handles[i] ));
+    }
+
+    CHECK( wheel.entries() == 0 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_cancel
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_cancel( void )
+{
+    CxTimerWheel  wheel;
+    CxTimerHandle handles[ 4 ];
+
+    memset( fired, 0, sizeof( fired ));
+
+    nowMillis = 1000;
+    wheel.begin( nowMillis );
+
+    handles[0] = wheel.start( 50,      expired, (void *) 0 );
+    handles[1] = wheel.start( 50,      expired, (void *) 1 );
+    handles[2] = wheel.start( 200000,  expired, (void *) 2 );
+    handles[3] = wheel.start( 2000000, expired, (void *) 3 );
+
+    CHECK( wheel.cancel( handles[1] ));
+    CHECK( wheel.cancel( handles[3] ));
+    CHECK( !wheel.cancel( handles[3] ));
+    CHECK( wheel.pending( handles[2] ));
+
+    run_until( &wheel, 1000, 2100000 );
+
+    CHECK( fired[0] == 1 );
+    CHECK( fired[1] == 0 );
+    CHECK( fired[2] == 1 );
+    CHECK( fired[3] == 0 );
+
+    // the node freed by a cancel is reused under a new generation, the old handle can't touch it
+
+    CxTimerHandle reused = wheel.start( 100, expired, (void *) 1 );
+
+    CHECK( !wheel.cancel( handles[1] ));
+    CHECK( wheel.pending( reused ));
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_pool
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_pool( void )
+{
+    CxTimerWheel wheel;
+
+    nowMillis = 0;
+    wheel.begin( nowMillis );
+
+    for (int i=0; i<TIMER_WHEEL_CAPACITY; i++) {
+        CHECK( wheel.start( 1000 + i, expired, (void *) 0 ) != TIMER_HANDLE_NONE );
+    }
+
+    CHECK( wheel.start( 10, expired, (void *) 0 ) == TIMER_HANDLE_NONE );
+    CHECK( wheel.entries() == TIMER_WHEEL_CAPACITY );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_restart_from_callback
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_restart_from_callback( void )
+{
+    CxTimerWheel wheel;
+
+    memset( fired, 0, sizeof( fired ));
+    chainWheel = &wheel;
+
+    nowMillis = 0;
+    wheel.begin( nowMillis );
+    wheel.start( 100, restart, (void *) 0 );
+
+    run_until( &wheel, 0, 700 );
+
+    CHECK( fired[0] == 1 );
+    CHECK( fired[ TIMERS - 1 ] == 1 );
+    CHECK( firedAt[ TIMERS - 1 ] - firedAt[0] >= 500 );
+    CHECK( !wheel.pending( chained ));
+}
+
+
+int main( void )
+{
+    test_levels( );
+    test_cancel( );
+    test_pool( );
+    test_restart_from_callback( );
+
+    return( check_report( "cxtimerwheel" ));
+}
@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzoneindex_bench.cpp
+//
+//  Benchmark for CxZoneIndex.  Reports how many ids share a home slot and the longest probe for the
+//  zones in use in the channel map and for synthetic maps up to the table's limit.  It also times
+//  find() for a hit, for a miss and for an id picked out of a longer command argument, against the
+//  plain walk over the ids that the index replaced.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxstring.h>
+#include <cxzoneindex.h>
+#include <string.h>
+#include "check.h"
+#include "bench.h"
+
+#define LOOKUPS  200000
+
+// the ids of the zones in use in the channel map in alarmsystem.ino, channel order
+
+static const char *zoneIds[] = {
+    "G_O_D",   "G_E_W",   "GE_S_D",  "ME_S_D",  "L_E_W",   "B_NL_W",  "B_NR_W",  "B_NC_W",
+    "K_NC_W",  "K_NL_W",  "K_NR_W",  "K_W_W",   "FR_E_W",  "FR_NR_W", "FR_NL_W", "FR_E_D",
+    "FR_NC_W", "SA_N_W",  "SA_W_W",  "SA_E_D",  "VR_SR_W", "VR_SL_W", "VR_W_W",  "MB_W_D",
+    "MB_NR_W", "MB_NL_W"
+};
+
+#define ZONE_IDS  ((int)(sizeof( zoneIds ) / sizeof( zoneIds[0] )))
+
+static const char *rooms[]    = { "B", "K", "FR", "SA", "VR", "MB", "B2", "B3", "L", "G", "GE", "ME", "O", "D" };
+static const char *compass[]  = { "N", "S", "E", "W", "NL", "NR", "NC", "SL", "SR" };
+
+static char        syntheticIds[ ZONE_INDEX_SLOTS ][ 16 ];
+static const char *ids[ ZONE_INDEX_SLOTS ];
+
+static int linear_find( const char *id, int count )
+{
+    for (int i = 0; i < count; i++) {
+        if (strcmp( ids[ i ], id ) == 0) return( i );
+    }
+    return( -1 );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// bench_ids
+//
+// count ids from ids[], a collision is an id whose home slot another id already had.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void bench_ids( const char *name, int count )
+{
+    static CxZoneIndex index;
+    static char        home[ ZONE_INDEX_SLOTS ];
+
+    index = CxZoneIndex();
+    memset( home, 0, sizeof( home ));
+
+    int collisions = 0;
+
+    for (int i = 0; i < count; i++) {
+
+        int slot = CxString::hashValue( ids[ i ] ) & (ZONE_INDEX_SLOTS - 1);
+        if (home[ slot ]) collisions++;
+        home[ slot ] = 1;
+
+        CHECK( index.add( ids[ i ], i ));
+    }
+
+    CHECK( index.entries() == count );
+
+    printf( "%s: %d ids, %d share a home slot (%.0f%%), longest probe %d\n",
+            name, count, collisions, 100.0 * collisions / count, index.maxProbe() );
+
+    // every id once per round so the probes are averaged over the whole map
+
+    int    found = 0;
+    double start = bench_seconds();
+    for (int l = 0; l < LOOKUPS; l++) {
+        found += (index.find( ids[ l % count ] ) == l % count);
+    }
+    bench_report( "find, hit", bench_seconds() - start, LOOKUPS );
+    CHECK( found == LOOKUPS );
+
+    found = 0;
+    start = bench_seconds();
+    for (int l = 0; l < LOOKUPS; l++) {
+        found += (linear_find( ids[ l % count ], count ) == l % count);
+    }
+    bench_report( "walk the ids, hit", bench_seconds() - start, LOOKUPS );
+    CHECK( found == LOOKUPS );
+
+    int missed = 0;
+    start = bench_seconds();
+    for (int l = 0; l < LOOKUPS; l++) {
+        missed += (index.find( (l & 1) ? "K_LN_W" : "X" ) == ZONE_INDEX_NONE);
+    }
+    bench_report( "find, miss", bench_seconds() - start, LOOKUPS );
+    CHECK( missed == LOOKUPS );
+
+    char argument[ 32 ];
+    snprintf( argument, sizeof( argument ), "%s,1", ids[ count / 2 ] );
+
+    found = 0;
+    start = bench_seconds();
+    for (int l = 0; l < LOOKUPS; l++) {
+        found += (index.find( argument, strlen( ids[ count / 2 ] )) == count / 2);
+    }
+    bench_report( "find, id in a command argument", bench_seconds() - start, LOOKUPS );
+    CHECK( found == LOOKUPS );
+
+    benchSink = found + missed;
+}
+
+
+int main( void )
+{
+    for (int i = 0; i < ZONE_IDS; i++) {
+        ids[ i ] = zoneIds[ i ];
+    }
+    bench_ids( "channel map", ZONE_IDS );
+
+    // ids in the same room_compass_type style, up to the half full limit
+
+    int made = 0;
+    for (int r = 0; made < ZONE_INDEX_SLOTS / 2; r++) {
+        for (int c = 0; c < 9 && made < ZONE_INDEX_SLOTS / 2; c++) {
+            snprintf( syntheticIds[ made ], sizeof( syntheticIds[0] ), "%s_%s_%c",
+                      rooms[ r % 14 ], compass[ c ], (r < 14) ? 'W' : 'D' );
+            ids[ made ] = syntheticIds[ made ];
+            made++;
+        }
+    }
+    bench_ids( "48 zones", 48 );
+    bench_ids( "64 zones", ZONE_INDEX_SLOTS / 2 );
+
+    return( check_report( "cxzoneindex_bench" ));
+}
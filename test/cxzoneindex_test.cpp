@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------------------------------------
+//  cxzoneindex_test.cpp
+//
+//  Host test for CxZoneIndex and CxString::hashValue.  Every id in the channel map has to come back
+//  with its own channel, including K_NL_W next to its anagram K_LN_W, which the old additive hash put
+//  in the same bucket.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <cxstring.h>
+#include <cxzoneindex.h>
+#include "check.h"
+
+// the symbolic names from the channel map in alarmsystem.ino, channel order
+
+static const char *zoneIds[] = {
+    "G_O_D",   "G_E_W",   "GE_S_D",  "ME_S_D",  "L_E_W",   "B_NL_W",  "B_NR_W",  "B_NC_W",
+    "K_NC_W",  "K_NL_W",  "K_NR_W",  "K_W_W",   "FR_E_W",  "FR_NR_W", "FR_NL_W", "FR_E_D",
+    "FR_NC_W", "SA_N_W",  "SA_W_W",  "SA_E_D",  "VR_SR_W", "VR_SL_W", "VR_W_W",  "MB_W_D",
+    "MB_NR_W", "MB_NL_W", "B2_E_W",  "1F_M",    "2F_M",    "B_M",     "X",       "X"
+};
+
+#define ZONE_IDS     ((int)(sizeof( zoneIds ) / sizeof( zoneIds[0] )))
+#define FIRST_X      30
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_hash
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_hash( void )
+{
+    CHECK( CxString::hashValue( "K_NL_W" ) != CxString::hashValue( "K_LN_W" ));
+    CHECK( CxString::hashValue( "B_NR_W" ) != CxString::hashValue( "B_RN_W" ));
+
+    // the object, whole string and prefix forms all agree
+
+    CxString id( "K_NL_W" );
+    CHECK( id.hashValue() == CxString::hashValue( "K_NL_W" ));
+    CHECK( CxString::hashValue( "K_NL_W,1", 6 ) == CxString::hashValue( "K_NL_W" ));
+
+    // no two distinct ids in the map share a hash
+
+    for (int i = 0; i < ZONE_IDS; i++) {
+        for (int j = i + 1; j < ZONE_IDS; j++) {
+            if (strcmp( zoneIds[ i ], zoneIds[ j ] ) == 0) continue;
+            CHECK( CxString::hashValue( zoneIds[ i ] ) != CxString::hashValue( zoneIds[ j ] ));
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_lookup
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_lookup( void )
+{
+    static CxZoneIndex index;
+
+    for (int c = 0; c < ZONE_IDS; c++) {
+        CHECK( index.add( zoneIds[ c ], c ));
+    }
+
+    CHECK( index.entries() == ZONE_IDS - 1 );
+    CHECK( index.maxProbe() >= 1 );
+
+    for (int c = 0; c < FIRST_X; c++) {
+        CHECK( index.find( zoneIds[ c ] ) == c );
+    }
+
+    // a repeated id keeps its first channel
+
+    CHECK( index.find( "X" ) == FIRST_X );
+
+    CHECK( index.find( "K_NL_W" ) == 9 );
+    CHECK( index.find( "K_LN_W" ) == ZONE_INDEX_NONE );
+    CHECK( index.find( "K_NL" )   == ZONE_INDEX_NONE );
+    CHECK( index.find( "K_NL_WX" ) == ZONE_INDEX_NONE );
+    CHECK( index.find( "" )       == ZONE_INDEX_NONE );
+
+    // ids picked out of a longer command argument
+
+    CHECK( index.find( "K_W_W,1", 5 )  == 11 );
+    CHECK( index.find( "K_NL_W 30", 6 ) == 9 );
+    CHECK( index.find( "K_NL_W 30", 5 ) == ZONE_INDEX_NONE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// test_full
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void test_full( void )
+{
+    static CxZoneIndex index;
+    static char        ids[ ZONE_INDEX_SLOTS + 1 ][ 8 ];
+
+    int added = 0;
+
+    for (int i = 0; i <= ZONE_INDEX_SLOTS; i++) {
+        snprintf( ids[ i ], sizeof( ids[ i ] ), "Z%d", i );
+        if (index.add( ids[ i ], i )) added++;
+    }
+
+    CHECK( added < ZONE_INDEX_SLOTS + 1 );
+    CHECK( index.entries() == added );
+
+    for (int i = 0; i < added; i++) {
+        CHECK( index.find( ids[ i ] ) == i );
+    }
+}
+
+
+int main( void )
+{
+    test_hash( );
+    test_lookup( );
+    test_full( );
+
+    return( check_report( "cxzoneindex" ));
+}
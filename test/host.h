@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------------------------------------
+//  host.h
+//
+//  Controls for the host stand-in behind Particle.h.  A test wires up the shift register chains, sets
+//  the zones, decides how the cloud behaves and reads back what the firmware published.  Only the
+//  tests that run the firmware itself need this.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+
+#ifndef _host_h_
+#define _host_h_
+
+#define HOST_PUBLISH_LOG      64            // most recent publishes kept for a test to look at
+#define HOST_PUBLISH_DATA     640
+
+struct HostPublish {
+    unsigned long millis;
+    char          name[ 64 ];
+    char          data[ HOST_PUBLISH_DATA ];
+};
+
+void host_input_chain( int loadPin, int clockPin, int dataPin, int bits, int serialLevel );
+// model a 165 chain of bits inputs on these pins, serialLevel is what its SER input is tied to
+
+void host_set_inputs( uint64_t bits );
+// the levels on the input chain's parallel inputs, bit 0 is the first read
+
+void host_stick_input( int level );
+// hold the input chain's data line at LOW or HIGH whatever the chain shifts out, -1 to free it
+
+void host_output_chain( int shiftClockPin, int storeClockPin, int dataPin );
+// model a 595 chain on these pins
+
+uint64_t host_output_latched( void );
+// what the output chain is showing, the most recently shifted bit in bit 0
+
+unsigned long host_output_shifts( void );
+// bits shifted into the output chain so far
+
+int host_pin( int pin );
+// level last written to a pin
+
+void host_advance( unsigned long ms );
+// move the clock on as if the firmware had sat in delay()
+
+void host_set_time_valid( int valid );
+// whether the cloud has set the clock yet, Time.now() counts from 1970 until it has
+
+void host_set_cloud( int connected, unsigned long publishMillis, int fail );
+// connection state, how long each publish takes and whether it fails
+
+unsigned long host_publishes( void );
+// publish calls made so far, failed or not
+
+int host_published( int back, HostPublish *publish );
+// the back'th most recent publish, 0 is the newest.  Returns FALSE if there isn't one
+
+void host_fail_queue_create( int fail );
+// make the next os_queue_create fail
+
+int host_retained_save( const char *path );
+int host_retained_load( const char *path );
+// the retained variables and EEPROM to and from a file, standing in for backup SRAM and flash across
+// a reset.  The retained section comes first so a test can corrupt the checkpoint at a known offset
+
+
+#endif
@@ -0,0 +1,455 @@
+//------------------------------------------------------------------------------------------------------------
+//  particle.cpp
+//
+//  The host stand-in behind Particle.h and host.h.  Linked into every test whose code touches the
+//  Device OS, on its own it is just EEPROM and a clock that only moves when asked.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "host.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+EEPROMClass  EEPROM;
+TimeClass    Time;
+SystemClass  System;
+CloudClass   Particle;
+
+#define HOST_EPOCH  1700000000UL            // what Time.now() reads the moment the cloud sets it
+
+//
+// ATOMIC_BLOCK, ahead of the locks below since CxHeapStats takes it for their allocations
+//
+static std::recursive_mutex atomicLock;
+
+//
+// the clock, in microseconds.  Only the firmware thread moves it, other threads wait on it.  The locks
+// here are never destroyed, the publisher thread is still waiting on them when main() returns and a
+// condition variable destroyed under a waiter never comes back
+//
+static std::mutex&              clockLock  = *new std::mutex;
+static std::condition_variable& clockMoved = *new std::condition_variable;
+static std::atomic<unsigned long> clockMicros( 0 );
+static std::thread::id         firmwareThread = std::this_thread::get_id();
+
+static int           timeValid = TRUE;
+static unsigned long randomState = 1;
+
+//
+// pins and the chains hanging off them
+//
+static int      pinLevel[ HOST_PINS ];
+
+static int      inLoadPin = -1, inClockPin = -1, inDataPin = -1, inBits = 0, inSerial = 0, inStuck = -1;
+static uint64_t inInputs = 0;
+static uint64_t inShift  = 0;
+
+static int           outShiftPin = -1, outStorePin = -1, outDataPin = -1;
+static uint64_t      outShift   = 0;
+static uint64_t      outLatched = 0;
+static unsigned long outShifts  = 0;
+
+//
+// the cloud
+//
+static std::mutex&   cloudLock = *new std::mutex;
+static int           cloudConnected = TRUE;
+static unsigned long cloudPublishMillis = 0;
+static int           cloudFail = FALSE;
+static unsigned long cloudPublishes = 0;
+static HostPublish   cloudLog[ HOST_PUBLISH_LOG ];
+
+static int queueCreateFails = FALSE;
+
+Timer *Timer::_timers = NULL;
+
+//
+// the retained section, the linker only provides these when something is retained
+//
+extern char __start_retained_user[] __attribute__(( weak ));
+extern char __stop_retained_user[] __attribute__(( weak ));
+
+
+//------------------------------------------------------------------------------------------------------------
+// clock
+//
+//------------------------------------------------------------------------------------------------------------
+
+static void wait_until( unsigned long targetMicros )
+{
+    std::unique_lock<std::mutex> lock( clockLock );
+    clockMoved.wait( lock, [targetMicros]{ return( (long)(clockMicros - targetMicros) >= 0 ); } );
+}
+
+//
+// on the firmware thread the clock moves a millisecond at a time so the software timers fire in step
+//
+static void advance_micros( unsigned long us )
+{
+    if (std::this_thread::get_id() != firmwareThread) {
+        wait_until( clockMicros + us );
+        return;
+    }
+
+    unsigned long target = clockMicros + us;
+
+    while ((long)(target - clockMicros) > 0) {
+
+        unsigned long step = 1000 - (clockMicros % 1000);
+        if ((long)(target - clockMicros) < (long) step) step = target - clockMicros;
+
+        {
+            std::lock_guard<std::mutex> lock( clockLock );
+            clockMicros += step;
+        }
+        clockMoved.notify_all();
+
+        if (clockMicros % 1000 == 0) Timer::fireDue( clockMicros / 1000 );
+    }
+
+    std::this_thread::yield();
+}
+
+unsigned long millis( void )                { return( clockMicros / 1000 ); }
+unsigned long micros( void )                { return( clockMicros ); }
+void          delay( unsigned long ms )     { advance_micros( ms * 1000 ); }
+void          delayMicroseconds( unsigned int us ) { advance_micros( us ); }
+
+void host_advance( unsigned long ms )       { advance_micros( ms * 1000 ); }
+void host_set_time_valid( int valid )       { timeValid = valid; }
+
+long random( long max )
+{
+    randomState = randomState * 1103515245UL + 12345UL;
+    return( max > 0 ? (long)((randomState >> 16) % (unsigned long) max) : 0 );
+}
+
+long random( long min, long max )
+{
+    return( min + random( max - min ));
+}
+
+time_t TimeClass::now( void )               { return( (timeValid ? HOST_EPOCH : 0) + millis() / 1000 ); }
+int    TimeClass::isValid( void )           { return( timeValid ); }
+
+uint32_t SystemClass::freeMemory( void )             { return( 50000 ); }
+uint32_t SystemClass::ticks( void )                  { return( (uint32_t)(clockMicros * 120) ); }
+uint32_t SystemClass::ticksPerMicrosecond( void )    { return( 120 ); }
+void     SystemClass::enableFeature( int feature )   { }
+String   SystemClass::deviceID( void )               { return( String( "0123456789abcdef01234567" )); }
+
+
+//------------------------------------------------------------------------------------------------------------
+// pins
+//
+// The 165 loads its inputs while LOAD is low and shifts towards the data pin on a rising clock, the
+// first register's SER input coming in behind.  The 595 shifts on a rising SHCP and shows what it has
+// on a rising STCP.
+//
+//------------------------------------------------------------------------------------------------------------
+
+void pinMode( int pin, PinMode mode ) { }
+
+void digitalWrite( int pin, int value )
+{
+    if (pin < 0 || pin >= HOST_PINS) return;
+
+    int rising = (pinLevel[ pin ] == LOW && value != LOW);
+    pinLevel[ pin ] = (value != LOW) ? HIGH : LOW;
+
+    if (pin == inLoadPin && value == LOW) {
+        inShift = inInputs;
+    }
+
+    if (pin == inClockPin && rising && pinLevel[ inLoadPin ] == HIGH) {
+        inShift = (inShift >> 1) | ((uint64_t)(inSerial ? 1 : 0) << (inBits - 1));
+    }
+
+    if (pin == outShiftPin && rising) {
+        outShift = (outShift << 1) | (pinLevel[ outDataPin ] ? 1 : 0);
+        outShifts++;
+    }
+
+    if (pin == outStorePin && rising) {
+        outLatched = outShift;
+    }
+}
+
+int digitalRead( int pin )
+{
+    if (pin == inDataPin && inStuck >= 0) return( inStuck );
+    if (pin == inDataPin) return( (int)(inShift & 1) );
+    if (pin < 0 || pin >= HOST_PINS) return( LOW );
+    return( pinLevel[ pin ] );
+}
+
+void host_input_chain( int loadPin, int clockPin, int dataPin, int bits, int serialLevel )
+{
+    inLoadPin  = loadPin;
+    inClockPin = clockPin;
+    inDataPin  = dataPin;
+    inBits     = bits;
+    inSerial   = serialLevel;
+}
+
+void     host_set_inputs( uint64_t bits )   { inInputs = bits; }
+void     host_stick_input( int level )      { inStuck = level; }
+
+void host_output_chain( int shiftClockPin, int storeClockPin, int dataPin )
+{
+    outShiftPin = shiftClockPin;
+    outStorePin = storeClockPin;
+    outDataPin  = dataPin;
+}
+
+uint64_t      host_output_latched( void )   { return( outLatched ); }
+unsigned long host_output_shifts( void )    { return( outShifts ); }
+int           host_pin( int pin )           { return( pinLevel[ pin ] ); }
+
+
+//------------------------------------------------------------------------------------------------------------
+// cloud
+//
+// A publish takes cloudPublishMillis of simulated time, which only holds up the thread publishing.
+//
+//------------------------------------------------------------------------------------------------------------
+
+bool CloudClass::connected( void )
+{
+    std::lock_guard<std::mutex> lock( cloudLock );
+    return( cloudConnected );
+}
+
+bool CloudClass::publish( const char *name, const char *data )
+{
+    unsigned long takes;
+    {
+        std::lock_guard<std::mutex> lock( cloudLock );
+        takes = cloudPublishMillis;
+    }
+
+    if (takes) advance_micros( takes * 1000 );
+
+    std::lock_guard<std::mutex> lock( cloudLock );
+
+    HostPublish *entry = &cloudLog[ cloudPublishes % HOST_PUBLISH_LOG ];
+    entry->millis = millis();
+    snprintf( entry->name, sizeof( entry->name ), "%s", name );
+    snprintf( entry->data, sizeof( entry->data ), "%s", data );
+    cloudPublishes++;
+
+    return( !cloudFail );
+}
+
+bool CloudClass::variable( const char *name, int *value )          { return( true ); }
+bool CloudClass::variable( const char *name, double *value )       { return( true ); }
+bool CloudClass::variable( const char *name, char *value )         { return( true ); }
+bool CloudClass::variable( const char *name, const char *value )   { return( true ); }
+bool CloudClass::function( const char *name, int (*handler)( String ))  { return( true ); }
+
+void host_set_cloud( int connected, unsigned long publishMillis, int fail )
+{
+    std::lock_guard<std::mutex> lock( cloudLock );
+    cloudConnected     = connected;
+    cloudPublishMillis = publishMillis;
+    cloudFail          = fail;
+}
+
+unsigned long host_publishes( void )
+{
+    std::lock_guard<std::mutex> lock( cloudLock );
+    return( cloudPublishes );
+}
+
+int host_published( int back, HostPublish *publish )
+{
+    std::lock_guard<std::mutex> lock( cloudLock );
+
+    if (back < 0 || back >= HOST_PUBLISH_LOG || (unsigned long) back >= cloudPublishes) return( FALSE );
+
+    *publish = cloudLog[ (cloudPublishes - 1 - back) % HOST_PUBLISH_LOG ];
+    return( TRUE );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// threads and queues
+//
+//------------------------------------------------------------------------------------------------------------
+
+struct HostQueue {
+    std::mutex              lock;
+    std::condition_variable changed;
+    size_t                  itemSize;
+    size_t                  itemCount;
+    size_t                  head;
+    size_t                  used;
+    char                   *items;
+};
+
+int os_queue_create( os_queue_t *queue, size_t itemSize, size_t itemCount, void *reserved )
+{
+    if (queueCreateFails) {
+        queueCreateFails = FALSE;
+        return( -1 );
+    }
+
+    HostQueue *q = new HostQueue;
+    q->itemSize  = itemSize;
+    q->itemCount = itemCount;
+    q->head      = 0;
+    q->used      = 0;
+    q->items     = (char *) malloc( itemSize * itemCount );
+
+    *queue = q;
+    return( 0 );
+}
+
+int os_queue_put( os_queue_t queue, const void *item, unsigned long delay, void *reserved )
+{
+    HostQueue *q = (HostQueue *) queue;
+    std::lock_guard<std::mutex> lock( q->lock );
+
+    if (q->used == q->itemCount) return( -1 );
+
+    memcpy( q->items + ((q->head + q->used) % q->itemCount) * q->itemSize, item, q->itemSize );
+    q->used++;
+    q->changed.notify_all();
+
+    return( 0 );
+}
+
+int os_queue_take( os_queue_t queue, void *item, unsigned long delay, void *reserved )
+{
+    HostQueue *q = (HostQueue *) queue;
+    std::unique_lock<std::mutex> lock( q->lock );
+
+    if (delay == CONCURRENT_WAIT_FOREVER) {
+        q->changed.wait( lock, [q]{ return( q->used > 0 ); } );
+    } else if (q->used == 0) {
+        return( -1 );
+    }
+
+    memcpy( item, q->items + q->head * q->itemSize, q->itemSize );
+    q->head = (q->head + 1) % q->itemCount;
+    q->used--;
+
+    return( 0 );
+}
+
+void host_fail_queue_create( int fail )     { queueCreateFails = fail; }
+
+Thread::Thread( const char *name, os_thread_fn_t function, void *arg, os_thread_prio_t priority, size_t stackSize )
+{
+    std::thread( function, arg ).detach();
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// timers
+//
+//------------------------------------------------------------------------------------------------------------
+
+bool Timer::start( void )
+{
+    if (!_active) {
+        _next   = _timers;
+        _timers = this;
+    }
+
+    _due    = millis() + _period;
+    _active = true;
+    return( true );
+}
+
+bool Timer::stop( void )
+{
+    for (Timer **t = &_timers; *t; t = &(*t)->_next) {
+        if (*t == this) {
+            *t = _next;
+            break;
+        }
+    }
+
+    _active = false;
+    return( true );
+}
+
+/* static */
+void Timer::fireDue( unsigned long nowMillis )
+{
+    for (Timer *t = _timers; t; ) {
+
+        Timer *next = t->_next;
+
+        if (t->_active && (long)(nowMillis - t->_due) >= 0) {
+            if (t->_oneShot) t->stop(); else t->_due += t->_period;
+            t->_call( t );
+        }
+
+        t = next;
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// atomic blocks
+//
+//------------------------------------------------------------------------------------------------------------
+
+HostAtomicBlock::HostAtomicBlock( void ) : _once( true ) { atomicLock.lock(); }
+HostAtomicBlock::~HostAtomicBlock( void )                { atomicLock.unlock(); }
+
+
+//------------------------------------------------------------------------------------------------------------
+// retained memory
+//
+// The file holds the retained section followed by EEPROM, everything a reset that keeps power leaves
+// behind.  A test saves it, starts itself again as a new process and loads it before setup().
+//
+//------------------------------------------------------------------------------------------------------------
+
+int host_retained_save( const char *path )
+{
+    FILE *file = fopen( path, "wb" );
+    if (file == NULL) return( FALSE );
+
+    size_t size = __stop_retained_user - __start_retained_user;
+    int    ok   = (fwrite( __start_retained_user, 1, size, file ) == size);
+
+    for (size_t a = 0; ok && a < EEPROM.length(); a++) {
+        ok = (fputc( EEPROM.read( a ), file ) != EOF);
+    }
+
+    fclose( file );
+    return( ok );
+}
+
+int host_retained_load( const char *path )
+{
+    FILE *file = fopen( path, "rb" );
+    if (file == NULL) return( FALSE );
+
+    size_t size = __stop_retained_user - __start_retained_user;
+    int    ok   = (fread( __start_retained_user, 1, size, file ) == size);
+
+    for (size_t a = 0; ok && a < EEPROM.length(); a++) {
+        int value = fgetc( file );
+        ok = (value != EOF);
+        if (ok) EEPROM.write( a, value );
+    }
+
+    fclose( file );
+    return( ok );
+}
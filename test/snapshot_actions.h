@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------------------------------------
+//  snapshot_actions.h
+//
+//  Turns two heartbeat or snapshot payloads into the VictorOps json that brings a receiver holding the
+//  first one in line with the second, one CRITICAL or RECOVERY message per zone whose open state
+//  differs.  Include after alarmsystem.ino, it uses the zone table from there.  The messages carry no
+//  sequence or event key, they aren't events the firmware sent.
+//
+//------------------------------------------------------------------------------------------------------------
+
+#ifndef _snapshot_actions_h_
+#define _snapshot_actions_h_
+
+typedef void (*SnapshotActionsHandler)( const char *json, void *arg );
+
+struct SnapshotActions {
+    SnapshotActionsHandler handler;
+    void                  *arg;
+    unsigned long          time;
+};
+
+static void snapshot_actions_zone( int channel, int action, void *arg )
+{
+    SnapshotActions *actions = (SnapshotActions *) arg;
+
+    if (channel >= TOTAL_CHANNELS) return;
+
+    CxString json = zoneTable[ channel ]->format_victorops_json( action == SNAPSHOT_ACTION_CRITICAL, actions->time );
+    actions->handler( json.data(), actions->arg );
+}
+
+
+//------------------------------------------------------------------------------------------------------------
+// snapshot_actions
+//
+// The messages are timed with the current payload's state_start_time.  Returns the number of messages,
+// -1 if current is older than known, or -2 if either payload has no snapshot in it.
+//
+//------------------------------------------------------------------------------------------------------------
+
+static int snapshot_actions( const char *known, const char *current, SnapshotActionsHandler handler, void *arg )
+{
+    CxZoneSnapshot  knownSnapshot;
+    CxZoneSnapshot  currentSnapshot;
+    SnapshotActions actions;
+
+    if (!knownSnapshot.parse( known ) || !currentSnapshot.parse( current )) return( -2 );
+
+    const char *time = strstr( current, "\"state_start_time\":" );
+
+    actions.handler = handler;
+    actions.arg     = arg;
+    actions.time    = time ? strtoul( time + strlen( "\"state_start_time\":" ), NULL, 10 ) : 0;
+
+    return( CxZoneSnapshot::reconcile( knownSnapshot, currentSnapshot, snapshot_actions_zone, &actions ));
+}
+
+
+#endif
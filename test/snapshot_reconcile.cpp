@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------------------------------------
+//  snapshot_reconcile.cpp
+//
+//  Receiving side tool for the zone snapshot in the heartbeat and the SYSTEM_SNAPSHOT event.  Reads
+//  payloads from stdin, one per line, the first being the last one the receiver acted on.  Each one
+//  after it is compared with the last one taken and the VictorOps json for the zones that differ is
+//  written, one per line.  A payload older than the last one taken is reported and skipped.  The
+//  channel map is the firmware's own, so rebuild this after changing it.
+//
+//      snapshot_reconcile < payloads
+//
+//------------------------------------------------------------------------------------------------------------
+
+#include <Particle.h>
+#include "../alarmsystem.ino"
+#include "snapshot_actions.h"
+
+static void print_json( const char *json, void *arg )
+{
+    (void) arg;
+    printf( "%s\n", json );
+}
+
+
+int main( int argc, char **argv )
+{
+    static char known[ 2 * PUBLISH_DATA_MAX ];
+    static char line[ 2 * PUBLISH_DATA_MAX ];
+    int         status = 0;
+
+    if (argc != 1) {
+        fprintf( stderr, "usage: %s < payloads\n", argv[0] );
+        return( 2 );
+    }
+
+    channel_load_list( );
+
+    known[0] = 0;
+
+    while (fgets( line, sizeof( line ), stdin )) {
+
+        if (line[0] == '\n' || line[0] == 0) continue;
+
+        if (known[0] == 0) {
+            CxZoneSnapshot snapshot;
+            if (snapshot.parse( line )) {
+                strcpy( known, line );
+            } else {
+                fprintf( stderr, "no snapshot in: %s", line );
+                status = 1;
+            }
+            continue;
+        }
+
+        int actions = snapshot_actions( known, line, print_json, NULL );
+
+        if (actions == -1) {
+            fprintf( stderr, "older than the last snapshot, skipped: %s", line );
+        } else if (actions < 0) {
+            fprintf( stderr, "no snapshot in: %s", line );
+            status = 1;
+        } else {
+            strcpy( known, line );
+        }
+    }
+
+    return( status );
+}